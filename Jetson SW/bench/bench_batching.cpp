@@ -0,0 +1,71 @@
+#include "batchscheduler.h"
+#include "inferencebackend.h"
+#include "preprocess.h"
+#include "readings.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Throughput against latency of BatchScheduler over a mock model, for batch size x deadline x
+// number of submitting threads. The live AI loop is a single producer per model, where a batch
+// never fills and every request waits out the deadline (producers:1); batches only form with
+// several streams submitting at once (producers:4)
+
+/* Mock model cost in the range of the head pose engines, in microseconds */
+#define BENCH_LAUNCH_OVERHEAD_US    2000
+#define BENCH_PER_INPUT_US          500
+/* Requests each producer submits, one at a time, per benchmark iteration */
+#define BENCH_REQUESTS_PER_PRODUCER 20
+
+static void BM_Batching(benchmark::State& state) {
+    const size_t maxBatch = static_cast<size_t>(state.range(0));
+    const int deadlineUs = static_cast<int>(state.range(1));
+    const int producers = static_cast<int>(state.range(2));
+    const size_t inputSize = 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT;
+
+    MockInferenceBackend backend(inputSize, READINGS_VALUE_COUNT, BENCH_LAUNCH_OVERHEAD_US, BENCH_PER_INPUT_US);
+    BatchScheduler scheduler([&backend, inputSize](const float* inputs, size_t count, std::vector<float>& outputs) {
+        return backend.inferBatch(inputs, count, inputSize, outputs);
+    }, inputSize, maxBatch, std::chrono::microseconds(deadlineUs));
+    std::vector<float> input(inputSize, 0.5f);
+
+    std::vector<std::vector<double>> latencies(producers);
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&scheduler, &input, &latencies, p] {
+                for (int r = 0; r < BENCH_REQUESTS_PER_PRODUCER; ++r) {
+                    auto submitted = std::chrono::steady_clock::now();
+                    scheduler.submit(input.data()).get();
+                    latencies[p].push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - submitted).count());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::vector<double> all;
+    for (const auto& perProducer : latencies) {
+        all.insert(all.end(), perProducer.begin(), perProducer.end());
+    }
+    std::sort(all.begin(), all.end());
+    double average = 0;
+    for (double latency : all) {
+        average += latency;
+    }
+    state.counters["avg_batch"] = scheduler.getAverageBatchSize();
+    state.counters["avg_ms"] = all.empty() ? 0 : average / all.size();
+    state.counters["p95_ms"] = all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(all.size() * 0.95))];
+    state.SetItemsProcessed(state.iterations() * producers * BENCH_REQUESTS_PER_PRODUCER);
+}
+BENCHMARK(BM_Batching)
+    ->ArgNames({"batch", "deadline_us", "producers"})
+    ->ArgsProduct({{1, 2, 4, 8}, {500, 2000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include "infer.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+
+// Per-frame AI latency of TRTEngineSingleton with head pose and eye gaze run one after the other
+// against eye gaze on a second thread, as AIComponent::detectAI does. The models are
+// MockInferenceBackend sleeps, so concurrent frames should take the longer of the two, not the sum
+
+/* Mock model latencies in microseconds */
+#define BENCH_HEAD_POSE_US      8000
+#define BENCH_EYE_GAZE_US       5000
+
+static const size_t inputSize = 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT;
+
+// Serve mock models on the singleton, once per process
+static TRTEngineSingleton* mockEngines() {
+    static TRTEngineSingleton* trt = [] {
+        TRTEngineSingleton* engines = TRTEngineSingleton::getInstance();
+        engines->setModelFactory([](const std::string& path, InferenceBackendType) {
+            int latencyUs = path == "headpose" ? BENCH_HEAD_POSE_US : BENCH_EYE_GAZE_US;
+            return std::unique_ptr<IInferenceBackend>(new MockInferenceBackend(inputSize, ENGINE_OUTPUT_SIZE, latencyUs, 0));
+        });
+        engines->setEngine1("headpose");
+        engines->setEngine2("eyegaze");
+        while (engines->getHeadPoseBackendName() == "None" || engines->getEyeGazeBackendName() == "None") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return engines;
+    }();
+    return trt;
+}
+
+static void BM_ModelsSequential(benchmark::State& state) {
+    TRTEngineSingleton* trt = mockEngines();
+    std::vector<float> input(inputSize, 0.5f);
+    for (auto _ : state) {
+        std::vector<float> headPose = trt->inferHeadPose(input.data());
+        std::vector<float> eyeGaze = trt->inferEyeGaze(input.data());
+        benchmark::DoNotOptimize(headPose.data());
+        benchmark::DoNotOptimize(eyeGaze.data());
+    }
+}
+BENCHMARK(BM_ModelsSequential)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ModelsConcurrent(benchmark::State& state) {
+    TRTEngineSingleton* trt = mockEngines();
+    std::vector<float> input(inputSize, 0.5f);
+    for (auto _ : state) {
+        std::vector<float> eyeGaze;
+        std::thread eyeGazeWorker([trt, &input, &eyeGaze] { eyeGaze = trt->inferEyeGaze(input.data()); });
+        std::vector<float> headPose = trt->inferHeadPose(input.data());
+        eyeGazeWorker.join();
+        benchmark::DoNotOptimize(headPose.data());
+        benchmark::DoNotOptimize(eyeGaze.data());
+    }
+}
+BENCHMARK(BM_ModelsConcurrent)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+#include "facedetectioncomponent.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
+
+// Frames per second through FaceDetectionComponent for 1 to 3 detection workers, tracking off so
+// every frame is a full detection. Needs the darknet model, taken from DMS_FACE_CFG and
+// DMS_FACE_WEIGHTS or the path the DMS manager loads by default, and runs on the opencv backend
+
+/* Frames pushed through the stage per benchmark iteration */
+#define BENCH_FRAMES            30
+/* How long to wait for one output frame before giving up on the run */
+#define BENCH_FRAME_TIMEOUT_MS  2000
+
+static std::string modelPath(const char* variable, const char* fallback) {
+    const char* value = std::getenv(variable);
+    return value ? value : fallback;
+}
+
+static void BM_FacePool(benchmark::State& state) {
+    const std::string cfg = modelPath("DMS_FACE_CFG", "/home/dms/DMS/ModularCode/modelconfigs/face-yolov3-tiny.cfg");
+    const std::string weights = modelPath("DMS_FACE_WEIGHTS", "/home/dms/DMS/ModularCode/modelconfigs/face-yolov3-tiny_41000.weights");
+    if (!std::ifstream(cfg) || !std::ifstream(weights)) {
+        state.SkipWithError("Face detection model not found, set DMS_FACE_CFG and DMS_FACE_WEIGHTS");
+        return;
+    }
+
+    ThreadSafeQueue<FramePacket> input, output;
+    ThreadSafeQueue<std::string> commands, faults;
+    FaceDetectionComponent detector(input, output, commands, faults);
+    detector.setWorkers(static_cast<int>(state.range(0)));
+    detector.setBackend("opencv");
+    detector.setTracking(1, FACE_TRACK_MIN_CONFIDENCE);
+    detector.setSearchWindow(0);
+    if (!detector.initialize(cfg, weights)) {
+        state.SkipWithError("Face detection model failed to load");
+        return;
+    }
+    detector.modelstatus = true;
+    detector.startDetection();
+
+    cv::Mat frame(480, 640, CV_8UC3, cv::Scalar(128, 128, 128));
+    uint64_t frameId = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < BENCH_FRAMES; ++i) {
+            FramePacket packet;
+            packet.frameId = frameId++;
+            packet.frame = frame;
+            input.push(std::move(packet));
+        }
+        for (int i = 0; i < BENCH_FRAMES; ++i) {
+            FramePacket packet;
+            if (!output.waitPopFor(packet, std::chrono::milliseconds(BENCH_FRAME_TIMEOUT_MS))) {
+                state.SkipWithError("Face detection stalled");
+                break;
+            }
+        }
+    }
+    detector.stopDetection();
+    state.SetItemsProcessed(state.iterations() * BENCH_FRAMES);
+}
+BENCHMARK(BM_FacePool)
+    ->ArgName("workers")
+    ->DenseRange(1, 3)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,66 @@
+#include "mappedfile.h"
+#include <benchmark/benchmark.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+// Loading an engine-sized blob through MappedFile against the istreambuf_iterator read the
+// engines used before. Both touch every byte, as deserialization does. The file stays in the
+// page cache between runs, so this compares the copies, not the disk
+
+/* Size of the dummy engine blob in MB */
+#define BENCH_ENGINE_BLOB_MB    64
+
+static const fs::path& blobPath() {
+    static const fs::path path = [] {
+        fs::path blob = fs::temp_directory_path() / fs::unique_path("dms-engine-bench-%%%%-%%%%.bin");
+        std::vector<char> data(static_cast<size_t>(BENCH_ENGINE_BLOB_MB) * 1024 * 1024);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<char>((i * 2654435761u) >> 24);
+        }
+        std::ofstream out(blob.string(), std::ios::binary);
+        out.write(data.data(), data.size());
+        return blob;
+    }();
+    return path;
+}
+
+// Sum one byte per page, so every page is faulted in
+static long touchPages(const char* data, size_t size) {
+    long sum = 0;
+    for (size_t i = 0; i < size; i += 4096) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static void BM_EngineLoadStreamed(benchmark::State& state) {
+    const std::string path = blobPath().string();
+    for (auto _ : state) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> streamed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        benchmark::DoNotOptimize(touchPages(streamed.data(), streamed.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fs::file_size(blobPath())));
+}
+BENCHMARK(BM_EngineLoadStreamed)->Unit(benchmark::kMillisecond);
+
+static void BM_EngineLoadMapped(benchmark::State& state) {
+    const std::string path = blobPath().string();
+    for (auto _ : state) {
+        MappedFile mapped(path);
+        benchmark::DoNotOptimize(touchPages(mapped.getData(), mapped.getSize()));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fs::file_size(blobPath())));
+}
+BENCHMARK(BM_EngineLoadMapped)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    fs::remove(blobPath());
+    return 0;
+}
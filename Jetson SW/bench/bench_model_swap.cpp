@@ -0,0 +1,66 @@
+#include "infer.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+
+// Time from setEngine1 until the new head pose model serves, switching between two mock models
+// that are cached against a cache with no budget, where every switch loads from scratch
+
+/* Simulated engine load time in milliseconds, deserialization and warm-up */
+#define BENCH_MODEL_LOAD_MS     20
+
+static const size_t modelInputSize = 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT;
+
+// Mock model named after its path, so the bench can tell which one serves
+class NamedMockBackend : public MockInferenceBackend {
+public:
+    explicit NamedMockBackend(const std::string& path)
+        : MockInferenceBackend(modelInputSize, ENGINE_OUTPUT_SIZE, 100, 0), path(path) {}
+    std::string getName() const override { return path; }
+    size_t getResidentBytes() const override { return 1024 * 1024; }
+
+private:
+    std::string path;
+};
+
+static TRTEngineSingleton* mockEngines() {
+    static TRTEngineSingleton* trt = [] {
+        TRTEngineSingleton* engines = TRTEngineSingleton::getInstance();
+        engines->setModelFactory([](const std::string& path, InferenceBackendType) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_MODEL_LOAD_MS));
+            return std::unique_ptr<IInferenceBackend>(new NamedMockBackend(path));
+        });
+        return engines;
+    }();
+    return trt;
+}
+
+static void switchHeadPose(TRTEngineSingleton* trt, const std::string& path) {
+    trt->setEngine1(path);
+    while (trt->getHeadPoseBackendName() != path) {
+        std::this_thread::yield();
+    }
+}
+
+static void runSwaps(benchmark::State& state, size_t budgetMB) {
+    TRTEngineSingleton* trt = mockEngines();
+    trt->setModelCacheBudget(budgetMB);
+    switchHeadPose(trt, "A");
+    switchHeadPose(trt, "B");
+    bool toA = true;
+    for (auto _ : state) {
+        switchHeadPose(trt, toA ? "A" : "B");
+        toA = !toA;
+    }
+}
+
+static void BM_SwapCached(benchmark::State& state) {
+    runSwaps(state, MODEL_CACHE_BUDGET_MB);
+}
+BENCHMARK(BM_SwapCached)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_SwapUncached(benchmark::State& state) {
+    runSwaps(state, 0);
+}
+BENCHMARK(BM_SwapUncached)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+BENCHMARK_MAIN();
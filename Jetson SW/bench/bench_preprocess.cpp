@@ -0,0 +1,62 @@
+#include "preprocess.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+// Fused preprocessing against the per-pixel reference and the chain the engines used before it,
+// from a camera frame down to the engine input
+
+static const float meanRGB[3] = {0.485f, 0.456f, 0.406f};
+static const float stdRGB[3] = {0.229f, 0.224f, 0.225f};
+
+// The resize/convertTo/cvtColor/forEach chain that preprocessToCHW replaced, HWC output
+static void preprocessLegacy(const cv::Mat& image, cv::Size size, cv::Mat& output) {
+    cv::resize(image, output, size);
+    output.convertTo(output, CV_32F);
+    cv::cvtColor(output, output, cv::COLOR_BGR2RGB);
+    for (int c = 0; c < 3; ++c) {
+        output.forEach<cv::Vec3f>([c](cv::Vec3f& pixel, const int* position) -> void {
+            pixel[c] = (pixel[c] / 255.0 - meanRGB[c]) / stdRGB[c];
+        });
+    }
+}
+
+static cv::Mat sampleFrame() {
+    cv::Mat frame(cv::Size(640, 480), CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    return frame;
+}
+
+static void BM_PreprocessFused(benchmark::State& state) {
+    const cv::Mat frame = sampleFrame();
+    const cv::Size size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+    std::vector<float> tensor(3 * size.area());
+    for (auto _ : state) {
+        preprocessToCHW(frame, size, tensor.data());
+        benchmark::DoNotOptimize(tensor.data());
+    }
+}
+BENCHMARK(BM_PreprocessFused)->Unit(benchmark::kMicrosecond);
+
+static void BM_PreprocessReference(benchmark::State& state) {
+    const cv::Mat frame = sampleFrame();
+    const cv::Size size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+    std::vector<float> tensor(3 * size.area());
+    for (auto _ : state) {
+        preprocessToCHWReference(frame, size, tensor.data());
+        benchmark::DoNotOptimize(tensor.data());
+    }
+}
+BENCHMARK(BM_PreprocessReference)->Unit(benchmark::kMicrosecond);
+
+static void BM_PreprocessLegacy(benchmark::State& state) {
+    const cv::Mat frame = sampleFrame();
+    const cv::Size size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+    cv::Mat output;
+    for (auto _ : state) {
+        preprocessLegacy(frame, size, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+}
+BENCHMARK(BM_PreprocessLegacy)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
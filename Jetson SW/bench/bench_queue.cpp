@@ -0,0 +1,102 @@
+#include "threadsafequeue.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// ThreadSafeQueue with its mutex and condition variable (lockfree:0) against the SPSC ring behind
+// enableLockFree (lockfree:1), at a capacity of eight items
+
+/* Capacity of the queue under test */
+#define BENCH_QUEUE_CAPACITY        8
+/* Items handed from the producer to the consumer thread per benchmark iteration */
+#define BENCH_QUEUE_ITEMS           65536
+/* Gap between pushes in the latency benchmark, keeps the queue near empty so the consumer waits */
+#define BENCH_QUEUE_PACE_NS         2000
+
+typedef std::chrono::steady_clock Clock;
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void configure(ThreadSafeQueue<int64_t>& queue, bool lockFree) {
+    queue.setCapacity(BENCH_QUEUE_CAPACITY, OverflowPolicy::Block);
+    if (lockFree) {
+        queue.enableLockFree(BENCH_QUEUE_CAPACITY);
+    }
+}
+
+// Uncontended cost of one push and one tryPop on the same thread
+static void BM_QueuePushPop(benchmark::State& state) {
+    ThreadSafeQueue<int64_t> queue;
+    configure(queue, state.range(0) != 0);
+    int64_t item = 0;
+    for (auto _ : state) {
+        queue.push(item);
+        queue.tryPop(item);
+        benchmark::DoNotOptimize(item);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuePushPop)->ArgName("lockfree")->Arg(0)->Arg(1);
+
+// Producer and consumer on separate threads, the producer pushes as fast as the queue accepts
+static void BM_QueueThroughput(benchmark::State& state) {
+    ThreadSafeQueue<int64_t> queue;
+    configure(queue, state.range(0) != 0);
+    for (auto _ : state) {
+        std::thread producer([&queue] {
+            for (int64_t i = 0; i < BENCH_QUEUE_ITEMS; ++i) {
+                queue.push(i);
+            }
+        });
+        int64_t item = 0;
+        for (int i = 0; i < BENCH_QUEUE_ITEMS; ++i) {
+            queue.waitAndPop(item);
+        }
+        benchmark::DoNotOptimize(item);
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_QUEUE_ITEMS);
+}
+BENCHMARK(BM_QueueThroughput)->ArgName("lockfree")->Arg(0)->Arg(1)->UseRealTime();
+
+// Push-to-pop latency of a paced producer, reported as percentiles in microseconds
+static void BM_QueueLatency(benchmark::State& state) {
+    ThreadSafeQueue<int64_t> queue;
+    configure(queue, state.range(0) != 0);
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(BENCH_QUEUE_ITEMS) * 8);
+    for (auto _ : state) {
+        std::thread producer([&queue] {
+            int64_t next = nowNs();
+            for (int i = 0; i < BENCH_QUEUE_ITEMS; ++i) {
+                while (nowNs() < next) {
+                }
+                queue.push(nowNs());
+                next += BENCH_QUEUE_PACE_NS;
+            }
+        });
+        int64_t pushedAt;
+        for (int i = 0; i < BENCH_QUEUE_ITEMS; ++i) {
+            queue.waitAndPop(pushedAt);
+            latencies.push_back(nowNs() - pushedAt);
+        }
+        producer.join();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentileUs = [&latencies](double fraction) {
+        return latencies[static_cast<size_t>(fraction * (latencies.size() - 1))] / 1000.0;
+    };
+    state.counters["p50_us"] = percentileUs(0.5);
+    state.counters["p99_us"] = percentileUs(0.99);
+    state.counters["p999_us"] = percentileUs(0.999);
+    state.counters["max_us"] = latencies.back() / 1000.0;
+    state.SetItemsProcessed(state.iterations() * BENCH_QUEUE_ITEMS);
+}
+BENCHMARK(BM_QueueLatency)->ArgName("lockfree")->Arg(0)->Arg(1)->Iterations(8)->UseRealTime();
+
+BENCHMARK_MAIN();
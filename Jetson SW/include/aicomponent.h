@@ -3,7 +3,13 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/face.hpp>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "readings.h"
+#include "preprocesscache.h"
+#include "inferencebackend.h"
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <numeric>
 #include <vector>
@@ -12,10 +18,9 @@
 class AIComponent {
 public:
     // Constructor
-    AIComponent(ThreadSafeQueue<cv::Mat>& inputQueue, 
-                      ThreadSafeQueue<cv::Rect>& faceRectQueue, 
-                      ThreadSafeQueue<std::vector<std::vector<float>>>& outputQueue, 
-                      ThreadSafeQueue<cv::Mat>& framesQueue, 
+    AIComponent(ThreadSafeQueue<FramePacket>& inputQueue, 
+                      ThreadSafeQueue<Readings>& outputQueue, 
+                      ThreadSafeQueue<FramePacket>& framesQueue, 
                       ThreadSafeQueue<std::string>& commandsQueue, 
                       ThreadSafeQueue<std::string>& faultsQueue);
 
@@ -37,17 +42,31 @@ public:
     // Update the eye gaze engine
     void updateEyeGazeEngine(const std::string& eyeGazeEnginePath);
 
+    // Run head pose and eye gaze on TensorRT or on the CPU
+    void updateInferenceBackend(InferenceBackendType type);
+
+    // Load engines into the model cache in the background so switching to them is immediate
+    void preloadModels(const std::vector<std::string>& headPosePaths, const std::vector<std::string>& eyeGazePaths);
+
+    // Memory budget of the model cache, least recently used models are evicted above it
+    void setModelCacheBudget(size_t budgetMB);
+
+    // Batch concurrent inference requests per model, maxBatch 0 or 1 turns batching off
+    void setBatching(size_t maxBatch, int deadlineUs);
+
     // Log performance metrics
     void logPerformanceMetrics();
 
     // Reset performance metrics
     void resetPerformanceMetrics();
 
+    // Normalized face tensors of recent frames, shared with any later consumer of the face crop
+    PreprocessCache& getPreprocessCache() { return preprocessCache; }
+
 private:
-    ThreadSafeQueue<cv::Mat>& inputQueue; // Queue for input frames
-    ThreadSafeQueue<cv::Rect>& faceRectQueue; // Queue for detected face rectangles
-    ThreadSafeQueue<std::vector<std::vector<float>>>& outputQueue; // Queue for output data
-    ThreadSafeQueue<cv::Mat>& framesQueue; // Queue for frames
+    ThreadSafeQueue<FramePacket>& inputQueue; // Queue for input frames with their face ROI
+    ThreadSafeQueue<Readings>& outputQueue; // Queue for output data
+    ThreadSafeQueue<FramePacket>& framesQueue; // Queue for frames
     ThreadSafeQueue<std::string>& commandsQueue; // Queue for commands
     ThreadSafeQueue<std::string>& faultsQueue; // Queue for faults
     std::thread AIDetectionThread; // Thread for head pose detection
@@ -58,11 +77,23 @@ private:
     // Main loop for head pose detection
     void AIDetectionLoop();
 
-    // Function to detect head pose in a frame
-    std::vector<std::vector<float>> detectAI(cv::Mat& frame);
+    // Function to detect head pose and eye gaze on the face crop of a packet
+    Readings detectAI(const FramePacket& packet, const cv::Mat& croppedFace);
+
+    PreprocessCache preprocessCache; // Model inputs keyed by frame ID and face ROI
 
-    // Helper function to detect the face rectangle in a frame
-    cv::Rect detectFaceRectangle(const cv::Mat& frame);
+    // Eye gaze runs on its own worker while head pose runs on the detection thread
+    std::thread eyeGazeThread;
+    std::mutex eyeGazeMtx;
+    std::condition_variable eyeGazeCv;
+    std::shared_ptr<const PreprocessedFace> eyeGazeJob; // Pending input, taken by the worker
+    std::vector<float> eyeGazeResult;
+    double eyeGazeJobTime = 0.0;
+    bool eyeGazeDone = false;
+    bool eyeGazeStop = false;
+
+    // Worker loop running eye gaze inference on submitted inputs
+    void eyeGazeWorkerLoop();
 
     // Members for performance metrics
     double totalDetectionTime = 0;
@@ -82,5 +113,9 @@ private:
     double minHeadPoseTime = std::numeric_limits<double>::max(), minEyeGazeTime = std::numeric_limits<double>::max();
     double totalHeadPoseTime = 0.0, totalEyeGazeTime = 0.0;
     size_t headPoseCount = 0, eyeGazeCount = 0;
+
+    // Wall time of both models per frame against the sum of the two model times
+    double maxFrameAITime = 0.0, totalFrameAITime = 0.0, totalModelSumTime = 0.0;
+    size_t frameAICount = 0;
 };
 
@@ -2,13 +2,15 @@
 
 #include <opencv2/opencv.hpp>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "framepool.h"
 #include <thread>
 #include <atomic>
 
 class BasicCameraComponent {
 public:
     // Constructor
-    BasicCameraComponent(ThreadSafeQueue<cv::Mat>& outputQueue, 
+    BasicCameraComponent(ThreadSafeQueue<FramePacket>& outputQueue, 
                          ThreadSafeQueue<std::string>& commandsQueue, 
                          ThreadSafeQueue<std::string>& faultsQueue);
     
@@ -35,11 +37,15 @@ private:
     std::thread captureThread; // Thread for capturing video
     bool running; // Flag to indicate if capturing is running
     int fps = 20; // Frames per second for capturing
-    ThreadSafeQueue<cv::Mat>& outputQueue; // Queue for output frames
+    uint64_t nextFrameId = 0; // ID given to the next captured frame, keeps counting across restarts
+    ThreadSafeQueue<FramePacket>& outputQueue; // Queue for output frames
     ThreadSafeQueue<std::string>& commandsQueue; // Queue for commands
     ThreadSafeQueue<std::string>& faultsQueue; // Queue for faults
 
     // Main loop for capturing video frames
     void captureLoop();
+
+    // Size the frame pool for the opened source
+    void reserveFramePool();
 };
 
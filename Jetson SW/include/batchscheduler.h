@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Largest batch the scheduler forms by default */
+#define BATCH_MAX_SIZE          4
+/* Longest time the first request of a batch waits for more, in microseconds */
+#define BATCH_DEADLINE_US       2000
+
+// Collects inference requests from any number of threads into batches of up to maxBatch, waiting
+// at most 'deadline' after the first request of a batch, runs one batched call and hands every
+// caller its own output. Requests are batched and answered in the order they were submitted
+class BatchScheduler {
+public:
+    // Runs 'count' contiguous inputs and writes their outputs back to back
+    typedef std::function<bool(const float* inputs, size_t count, std::vector<float>& outputs)> BatchRunner;
+
+    // inputSize is in floats
+    BatchScheduler(BatchRunner runner, size_t inputSize, size_t maxBatch, std::chrono::microseconds deadline);
+    ~BatchScheduler();
+
+    // Queue one input. 'input' must stay valid until the future is ready. A failed batch gives
+    // every request in it an empty output
+    std::future<std::vector<float>> submit(const float* input);
+
+    size_t getBatchCount() const;
+    double getAverageBatchSize() const;
+
+private:
+    struct Request {
+        const float* input;
+        std::promise<std::vector<float>> result;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    BatchRunner runner;
+    size_t inputSize;
+    size_t maxBatch;
+    std::chrono::microseconds deadline;
+
+    mutable std::mutex mtx;
+    std::condition_variable requestCv;
+    std::deque<Request> requests;
+    bool stopping = false;
+    size_t batchCount = 0;
+    size_t requestCount = 0;
+    std::thread worker;
+
+    std::vector<float> batchInput;  // Gathered inputs, reused between batches
+    std::vector<float> batchOutput;
+
+    void workerLoop();
+
+    BatchScheduler(const BatchScheduler&) = delete;
+    BatchScheduler& operator=(const BatchScheduler&) = delete;
+};
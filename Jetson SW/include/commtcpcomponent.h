@@ -3,6 +3,9 @@
 #include <thread>
 #include <atomic>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "readings.h"
+#include "latencytracker.h"
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <netinet/in.h>
@@ -16,13 +19,17 @@
 #define MAX_FDT_THRESHOLD       100
 #define MIN_FDT_THRESHOLD       0
 
+/* How long the command client waits for readings before polling the socket for commands */
+#define COMMAND_POLL_TIMEOUT_MS 10
+
 class CommTCPComponent {
 public:
     // Constructor
-    CommTCPComponent(int port, ThreadSafeQueue<cv::Mat>& outputQueue, 
-                     ThreadSafeQueue<std::vector<std::vector<float>>>& readingsQueue, 
+    CommTCPComponent(int port, ThreadSafeQueue<FramePacket>& outputQueue, 
+                     ThreadSafeQueue<Readings>& readingsQueue, 
                      ThreadSafeQueue<std::string>& commandsQueue, 
-                     ThreadSafeQueue<std::string>& faultsQueue);
+                     ThreadSafeQueue<std::string>& faultsQueue,
+                     LatencyTracker& latencyTracker);
     
     // Destructor
     ~CommTCPComponent();
@@ -57,10 +64,11 @@ private:
     std::atomic<bool> running;
     std::thread frameThread;  // Thread handling frame transmissions
     std::thread commandThread;  // Thread handling command receptions and data transmissions
-    ThreadSafeQueue<cv::Mat>& outputQueue; // Queue for sending frames to connected clients
-    ThreadSafeQueue<std::vector<std::vector<float>>>& readingsQueue; // Queue for sending readings to connected clients
+    ThreadSafeQueue<FramePacket>& outputQueue; // Queue for sending frames to connected clients
+    ThreadSafeQueue<Readings>& readingsQueue; // Queue for sending readings to connected clients
     ThreadSafeQueue<std::string>& commandsQueue;  // Queue for processing commands
     ThreadSafeQueue<std::string>& faultsQueue;  // Queue for reporting faults
+    LatencyTracker& latencyTracker;  // Per-frame stage latencies, recorded once a frame is sent
 
     size_t totalFrameDataSent = 0;
     size_t totalCommandDataSent = 0;
@@ -76,7 +84,7 @@ private:
     void handleFrameClient(int clientSocket);  // Handles frame transmission to a client
     void handleCommandClient(int clientSocket); // Handles command reception from a client
 
-    // Serialize a 2D vector of floats to a byte array
-    std::vector<uint8_t> serialize(const std::vector<std::vector<float>>& data);
+    // Serialize a 2D vector of floats and append it to a byte array
+    void serialize(const Readings& readings, std::vector<uint8_t>& buffer);
 };
 
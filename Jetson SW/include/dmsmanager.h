@@ -3,20 +3,26 @@
 #include <thread>
 #include <signal.h>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "readings.h"
 #include "basiccameracomponent.h"
 #include "facedetectioncomponent.h"
 #include "aicomponent.h"
 #include "commtcpcomponent.h"
+#include "latencytracker.h"
+
+/* Models preloaded into the model cache at startup, format <head pose ids>;<eye gaze ids>, ids comma separated */
+#define MODEL_PRELOAD_AT_STARTUP    "AY;mobilenetv3"
 
 
 
 
 class DMSManager {
 public:
-    DMSManager(ThreadSafeQueue<cv::Mat>& cameraQueue,
-               ThreadSafeQueue<cv::Mat>& faceDetectionQueue, ThreadSafeQueue<cv::Rect>& faceRectQueue,
-               ThreadSafeQueue<std::vector<std::vector<float>>>& AIDetectionQueue, 
-               ThreadSafeQueue<cv::Mat>& framesQueue, 
+    DMSManager(ThreadSafeQueue<FramePacket>& cameraQueue,
+               ThreadSafeQueue<FramePacket>& faceDetectionQueue,
+               ThreadSafeQueue<Readings>& AIDetectionQueue, 
+               ThreadSafeQueue<FramePacket>& framesQueue, 
                ThreadSafeQueue<cv::Mat>& tcpOutputQueue, 
                int tcpPort,
                ThreadSafeQueue<std::string>& commandsQueue, ThreadSafeQueue<std::string>& faultsQueue);
@@ -31,20 +37,35 @@ public:
     void clearQueues();
     void setupSignalHandlers();
 
+    // Bound one of the pipeline queues by name (camera, faceDetection, AIDetection, frames,
+    // tcpOutput, commands, faults). Capacity 0 makes the queue unbounded. Returns false for an
+    // unknown queue, or a capacity change or DropOldest/KeepLatest policy on a lock-free one
+    bool setQueuePolicy(const std::string& queueName, size_t capacity, OverflowPolicy policy);
+
+    // Switch the camera link, the only single-producer/single-consumer one, to the lock-free ring.
+    // Only valid before startSystem() launches the component threads. faceDetection is fed by every
+    // face detection worker, and AIDetection and frames are read by one thread per TCP client.
+    // The camera mailbox has to be given a Block or DropNewest policy first, the ring cannot overwrite
+    bool setQueueLockFree(const std::string& queueName, size_t capacity);
+
+    // Log depth and drops for every queue, plus rates, wait and dwell times when built with
+    // QUEUE_INSTRUMENTATION (make QUEUE_STATS=1)
+    void logQueueMetrics();
+
     // Function to handle the different types of commands 
     void handleCommand(std::string& command);
 
 private:
+    LatencyTracker latencyTracker; // Declared before tcpComponent, which records into it
     BasicCameraComponent cameraComponent;
     FaceDetectionComponent faceDetectionComponent;
     AIComponent AiComponent;
     CommTCPComponent tcpComponent; 
 
-    ThreadSafeQueue<cv::Mat>& cameraQueue;
-    ThreadSafeQueue<cv::Mat>& faceDetectionQueue;
-    ThreadSafeQueue<cv::Rect>& faceRectQueue;
-    ThreadSafeQueue<std::vector<std::vector<float>>>& AIDetectionQueue;
-    ThreadSafeQueue<cv::Mat>& framesQueue;
+    ThreadSafeQueue<FramePacket>& cameraQueue;
+    ThreadSafeQueue<FramePacket>& faceDetectionQueue;
+    ThreadSafeQueue<Readings>& AIDetectionQueue;
+    ThreadSafeQueue<FramePacket>& framesQueue;
     ThreadSafeQueue<cv::Mat>& tcpOutputQueue;
     ThreadSafeQueue<std::string>& commandsQueue;
     ThreadSafeQueue<std::string>& faultsQueue;
@@ -59,6 +80,13 @@ private:
     bool running;
     bool firstRun = true;
 
+    // Default capacities and overflow policies for the pipeline queues
+    void configureQueues();
+
+    // Parse a numeric argument of 'command', a malformed or out of range value is logged and
+    // reported as a Command_fault instead of throwing out of commandsLoop
+    bool parseCommandInt(const std::string& command, const std::string& text, int& value);
+
     // Component loops that start in their own thread
     void cameraLoop();
     void faceDetectionLoop();
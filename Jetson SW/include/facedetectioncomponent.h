@@ -2,25 +2,56 @@
 
 #include <opencv2/opencv.hpp>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "facetracker.h"
+#include "yolodecode.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <chrono>
 #include <limits>
 
+/* Full detections run every FACE_DETECT_EVERY_N frames, the tracker fills the frames in between */
+#define FACE_DETECT_EVERY_N         3
+/* Tracker match score, in percent, below which a frame is re-detected right away */
+#define FACE_TRACK_MIN_CONFIDENCE   70
+/* Network input size of a full-frame detection */
+#define FACE_DETECT_INPUT_SIZE      320
+/* Network input size of a detection inside the search window, a multiple of 32 */
+#define FACE_SEARCH_INPUT_SIZE      160
+/* Search window around the last face, as a fraction of the face size on each side */
+#define FACE_SEARCH_MARGIN          0.5
+/* Consecutive misses in the search window before falling back to a full-frame scan */
+#define FACE_SEARCH_MAX_MISSES      2
+/* Detection workers, each with its own network, so the next frame is detected while this one finishes */
+#define FACE_DETECT_WORKERS         2
+/* Backend used for a newly loaded model, "auto" times every available backend and keeps the fastest */
+#define FACE_DETECT_DEFAULT_BACKEND "auto"
+/* Forward passes per backend before and while timing it */
+#define FACE_BACKEND_WARMUP_RUNS    2
+#define FACE_BACKEND_TIMED_RUNS     5
+
 class FaceDetectionComponent {
 public:
     // Constructor
-    FaceDetectionComponent(ThreadSafeQueue<cv::Mat>& inputQueue, 
-                           ThreadSafeQueue<cv::Mat>& outputQueue, 
-                           ThreadSafeQueue<cv::Rect>& faceRectQueue, 
+    FaceDetectionComponent(ThreadSafeQueue<FramePacket>& inputQueue, 
+                           ThreadSafeQueue<FramePacket>& outputQueue, 
                            ThreadSafeQueue<std::string>& commandsQueue, 
                            ThreadSafeQueue<std::string>& faultsQueue);
     
     // Destructor
     ~FaceDetectionComponent();
 
-    // Initialize the face detection component
+    // Initialize the face detection component on the configured backend, timing the candidates first for "auto"
     bool initialize(const std::string& modelConfiguration, const std::string& modelWeights);
 
+    // Select the DNN backend and target: cuda, cuda_fp16, opencv, opencl, opencl_fp16 or auto. Reloads a
+    // loaded model, so detection must be stopped. Returns false for an unknown name or a failed reload
+    bool setBackend(const std::string& name);
+
     // Start the face detection loop
     void startDetection();
 
@@ -30,6 +61,17 @@ public:
     // Set the face detection threshold
     void setFDT(int fdt);
 
+    // Detect every 'detectEvery' frames (1 turns tracking off) and re-detect when the tracker's
+    // match score drops below 'minConfidence' percent
+    void setTracking(int detectEvery, int minConfidence);
+
+    // Detect inside a window around the last face, scanning the full frame after 'maxMisses'
+    // consecutive misses in the window. 0 always scans the full frame
+    void setSearchWindow(int maxMisses);
+
+    // Number of detection workers, each loading its own network. Applied by the next initialize()
+    void setWorkers(int count);
+
     // Log performance metrics
     void logPerformanceMetrics();
 
@@ -40,28 +82,82 @@ public:
     void resetPerformanceMetrics();
 
 private:
-    ThreadSafeQueue<cv::Mat>& inputQueue; // Queue for input frames
-    ThreadSafeQueue<cv::Mat>& outputQueue; // Queue for output frames
-    ThreadSafeQueue<cv::Rect>& faceRectQueue; // Queue for detected face rectangles
+    // A frame on its way through the stage. Frames leave in the order they arrived, a finished
+    // detection waits for the frames before it
+    struct DetectionJob {
+        FramePacket packet;
+        bool detect = false;      // Sent to a worker, false for tracked and passed through frames
+        bool done = false;
+        bool failed = false;
+        cv::Rect area;            // Part of the frame the worker searches
+        int inputSize = FACE_DETECT_INPUT_SIZE;
+        bool tracked = false;     // The tracker ran on the frame, trackedRoi is valid
+        cv::Rect trackedRoi;
+        std::vector<FaceCandidate> faces; // Found by the worker, strongest first
+        size_t candidates = 0;    // Boxes that passed the objectness scan, before NMS
+        double detectionTime = 0;
+        double decodeTime = 0;    // Part of detectionTime spent decoding the outputs
+        std::chrono::high_resolution_clock::time_point doneTime;
+    };
+
+    ThreadSafeQueue<FramePacket>& inputQueue; // Queue for input frames
+    ThreadSafeQueue<FramePacket>& outputQueue; // Queue for output frames, carrying the detected face
     ThreadSafeQueue<std::string>& commandsQueue; // Queue for commands
     ThreadSafeQueue<std::string>& faultsQueue; // Queue for faults
-    cv::dnn::Net net; // DNN network for face detection
+    std::string backendName = FACE_DETECT_DEFAULT_BACKEND; // Requested backend, may be "auto"
+    std::string activeBackend;        // Backend the loaded networks run on
+    double activeBackendLatency = 0;  // Its average forward time when loaded, in ms
+    std::string configPath;           // Loaded model, for reloading on a backend change
+    std::string weightsPath;
+    std::vector<cv::dnn::Net> nets; // DNN networks for face detection, one per worker as a Net is not thread safe
     std::thread detectionThread; // Thread for face detection
+    std::vector<std::thread> workers; // Threads running the networks
+    int workerCount = FACE_DETECT_WORKERS; // Networks loaded by initialize()
+
+    std::mutex pipelineMtx; // Guards the jobs, tracker, search state and metrics
+    std::condition_variable workCv; // Wakes workers for a new job
+    std::condition_variable slotCv; // Wakes the detection loop when a worker frees up
+    std::deque<std::shared_ptr<DetectionJob>> pendingJobs; // Waiting for a worker
+    std::deque<std::shared_ptr<DetectionJob>> inFlight; // Every frame not yet passed on, in arrival order
+    int detectionsInFlight = 0;
+    bool workersRunning = false;
 
-    bool running; // Flag to indicate if detection is running
-    float fdt = 90; // Face detection threshold
+    std::atomic<bool> running; // Flag to indicate if detection is running, read by the detection loop without pipelineMtx
+    std::atomic<float> fdt{90}; // Face detection threshold, read by the workers
 
-    // Main loop for face detection
+    // Times every available backend on the loaded model, logs the results and returns the fastest
+    std::string autotuneBackend();
+
+    // Main loop for face detection, tracks or hands each frame to a worker
     void detectionLoop();
 
-    // Function to detect faces in a frame
-    void detectFaces(cv::Mat& frame);
+    // Runs detections with nets[index]
+    void workerLoop(size_t index);
+
+    // Passes on finished frames from the front of inFlight. Called with pipelineMtx held
+    void flushLocked();
+
+    // Stores a worker's result in the job's packet and restarts the tracker on it. Called with pipelineMtx held
+    void applyDetection(DetectionJob& job);
 
-    // Helper function to get the rectangle of the face from detection data
-    cv::Rect getFaceRect(const float* detection, const cv::Mat& frame);
+    // Function to detect faces in 'area' of a frame into the job's faces, never modifies the frame.
+    // Returns false if the detection failed
+    bool detectFaces(cv::dnn::Net& net, DetectionJob& job);
 
-    int frameCounter = 0; // Counter for frames processed
-    int skipRate = 3; // Frame skip rate
+    // Records how far the tracker was from the detection it is being replaced by
+    void recordDrift(const cv::Rect& tracked, const cv::Rect& detected);
+
+    // Region and network input size for the next detection
+    cv::Rect nextSearchArea(const cv::Mat& frame, int& inputSize) const;
+
+    FaceTracker tracker;
+    int frameCounter = 0; // Frames tracked since the last detection
+    std::atomic<int> skipRate{FACE_DETECT_EVERY_N}; // Detect every skipRate frames
+    std::atomic<int> trackConfidence{FACE_TRACK_MIN_CONFIDENCE}; // Re-detect below this match score, in percent
+    std::atomic<int> maxSearchMisses{FACE_SEARCH_MAX_MISSES}; // 0 turns the search window off
+    bool hasLastFace = false; // lastFace is valid
+    cv::Rect lastFace;        // Most recent face, detected or tracked
+    int searchMisses = 0;     // Consecutive misses inside the search window
 
     // Members for performance metrics
     double totalDetectionTime = 0;
@@ -71,6 +167,40 @@ private:
     std::chrono::high_resolution_clock::time_point lastTime;
     double fps = 0;
 
+    // Members for tracking metrics
+    int detectedFrames = 0;
+    int trackedFrames = 0;
+    int lowConfidenceDetections = 0; // Detections forced by a weak or lost track
+    int trackingRuns = 0;
+    double totalTrackingTime = 0;
+    double maxTrackingTime = 0;
+    int driftSamples = 0;
+    double totalDrift = 0;     // Center distance between track and detection, in pixels
+    double maxDrift = 0;
+    double totalDriftIoU = 0;
+
+    // Members for search window metrics
+    int windowedDetections = 0;
+    int fullFrameDetections = 0;
+    int windowMisses = 0;
+    double totalWindowedTime = 0;
+    double totalFullFrameTime = 0;
+
+    // Members for pipelining metrics
+    int outputFrames = 0;
+    int maxDetectionsInFlight = 0;
+    double totalReorderWait = 0; // Time finished detections waited for earlier frames
+    double maxReorderWait = 0;
+
+    // Members for output decode metrics
+    double totalDecodeTime = 0;
+    double maxDecodeTime = 0;
+    double totalWorkerTime = 0; // Detection time measured by the workers, for the decode share
+    size_t totalCandidates = 0;
+    size_t totalFacesKept = 0;
+
+    void resetPerformanceMetricsLocked();
+
     // Function to update performance metrics
     void updatePerformanceMetrics(double detectionTime);
 
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/* Longest side of the face template, larger faces are tracked on a downscaled image */
+#define FACE_TRACK_TEMPLATE_SIZE    64
+/* Search area around the last position, as a fraction of the face size on each side */
+#define FACE_TRACK_SEARCH_MARGIN    0.5
+
+// Follows the last detected face between detections by template matching (normalized cross
+// correlation) in a window around its previous position. The template is only taken on reset(),
+// so errors do not accumulate from frame to frame; the caller re-detects to refresh it
+class FaceTracker {
+public:
+    // Start tracking 'roi' in 'frame'
+    void reset(const cv::Mat& frame, const cv::Rect& roi);
+
+    // Forget the face, track() fails until the next reset()
+    void clear() { hasTarget = false; }
+
+    bool isTracking() const { return hasTarget; }
+
+    // Find the face in 'frame', updating 'roi' and 'confidence' (match score, -1..1). Returns false
+    // when there is no target or no search area left inside the frame
+    bool track(const cv::Mat& frame, cv::Rect& roi, double& confidence);
+
+private:
+    bool hasTarget = false;
+    cv::Mat faceTemplate;   // Grayscale, scaled by 'scale'
+    double scale = 1.0;     // Template pixels per frame pixel
+    cv::Rect lastRoi;       // Frame coordinates
+};
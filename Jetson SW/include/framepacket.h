@@ -0,0 +1,28 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+
+// A captured frame together with what the pipeline learned about it. Travels as one unit
+// camera -> face detection -> AI -> TCP, so the face rectangle can never drift to another frame
+struct FramePacket {
+    typedef std::chrono::steady_clock Clock;
+
+    uint64_t frameId = 0;            // Monotonic, assigned at capture
+    Clock::time_point captureTime;   // When the camera delivered the frame
+    cv::Mat frame;
+
+    bool faceSearched = false;       // Face detection ran on this frame
+    bool hasRoi = false;             // A face was found, roi is valid
+    cv::Rect roi;                    // Face rectangle in frame coordinates
+
+    // Per-stage timestamps, left at the clock epoch when a stage did not run
+    Clock::time_point faceDetectionStart;
+    Clock::time_point faceDetectionEnd;
+    Clock::time_point aiStart;
+    Clock::time_point aiEnd;
+    Clock::time_point encodeStart;
+    Clock::time_point encodeEnd;
+    Clock::time_point sendEnd;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+/* Number of preallocated capture buffers, covers every frame alive at once along the pipeline */
+#define FRAME_POOL_SIZE     8
+
+/* OpenCV 4.3 switched the MatAllocator access flags from int to cv::AccessFlag */
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 3)
+typedef cv::AccessFlag FramePoolAccessFlag;
+#else
+typedef int FramePoolAccessFlag;
+#endif
+
+// cv::MatAllocator handing out fixed-size, preallocated frame buffers. A buffer goes back to the
+// pool when the last cv::Mat referencing it is released, on whichever thread that happens.
+// Requests that do not fit a block, or arrive while every block is in use, fall back to the heap
+// and are counted as pool exhaustion. Set as the allocator of the capture Mat only, so
+// intermediate Mats created by later stages keep the default allocator.
+class FramePool : public cv::MatAllocator {
+public:
+    // Never deleted: cv::Mats in flight reference the allocator until they are released
+    static FramePool* getInstance();
+
+    // Drop the free blocks and preallocate 'blockCount' blocks of 'blockBytes'. Blocks still in use
+    // are freed to the heap when released. No-op if the pool already has this geometry
+    void reserve(size_t blockBytes, size_t blockCount);
+
+    size_t getBlockSize() const;
+
+    // cv::MatAllocator interface
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           FramePoolAccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, FramePoolAccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    // Log pool hits, exhaustion and allocations per second, then reset the counters
+    void logPoolMetrics();
+
+private:
+    static FramePool* instance;
+    static std::mutex instanceMtx;
+
+    mutable std::mutex mtx;
+    mutable std::vector<uchar*> freeBlocks;
+    size_t blockSize = 0;
+    size_t blockCount = 0;
+    int generation = 0; // Bumped by reserve(), blocks from an older generation are not reused
+
+    // Metrics, guarded by mtx
+    mutable size_t allocationCount = 0;
+    mutable size_t pooledCount = 0;
+    mutable size_t exhaustedCount = 0;
+    mutable size_t inUse = 0;
+    mutable size_t peakInUse = 0;
+    std::chrono::steady_clock::time_point metricsStart;
+
+    FramePool();
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+};
@@ -1,376 +1,651 @@
-#ifndef INFER_H
-#define INFER_H
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <mutex>
-#include <NvInfer.h>
-#include <opencv2/opencv.hpp>
-#include <cuda_runtime_api.h>
-#include <cuda_runtime.h>
-#include <unistd.h>
-
-struct CPUUsage {
-    long idleTime;
-    long totalTime;
-};
-
-using namespace nvinfer1;
-
-class Logger : public ILogger {
-    void log(Severity severity, const char* msg) noexcept override {
-        if (severity != Severity::kINFO) std::cout << msg << std::endl;
-    }
-} gLogger;
-
-class TRTEngineSingleton {
-private:
-    static TRTEngineSingleton* instance;
-    static std::mutex mtx; // Mutex for thread safety
-
-    ICudaEngine* engine1; // Head pose engine
-    ICudaEngine* engine2; // Eye gaze engine
-
-    size_t peakHeadPoseGpuMemoryUsage = 0;
-    size_t peakEyeGazeGpuMemoryUsage = 0;
-    size_t totalCpuMemoryUsageHeadPose = 0;
-    size_t totalCpuMemoryUsageEyeGaze = 0;
-    size_t headPoseInferenceCount = 0;
-    size_t eyeGazeInferenceCount = 0;
-    size_t totalCpuUsageEyeGaze = 0;
-    size_t totalCpuUsageHeadPose = 0;
-
-    TRTEngineSingleton() : engine1(nullptr), engine2(nullptr) {
-        // Load engines if you want it to be loaded at startup using loadEngines() method
-    }
-
-public:
-    static TRTEngineSingleton* getInstance() {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (!instance) {
-            instance = new TRTEngineSingleton();
-        }
-        return instance;
-    }
-
-    void loadEngines() {
-        engine1 = loadEngine("/home/dms/DMS/ModularCode/include/Ay.engine");
-        engine2 = loadEngine("/home/dms/DMS/ModularCode/modelconfigs/mobilenetv3_engine.engine");
-        std::cout << "Loaded engines successfully." << std::endl;
-        if (!engine1 || !engine2) {
-            std::cerr << "Failed to load one or both engines" << std::endl;
-        }
-    }
-
-    void setEngine1(const std::string& enginePath) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (enginePath == "No Head Pose") {
-            std::cout << "Skipping load of head pose engine." << std::endl;
-            if (engine1) {
-                engine1->destroy();
-                engine1 = nullptr;
-            }
-            return;
-        }
-        std::cout << "Loading new engine for head pose from: " << enginePath << std::endl;
-        if (engine1) {
-            engine1->destroy();
-            engine1 = nullptr;
-        }
-        ICudaEngine* newEngine = loadEngine(enginePath);
-        if (newEngine) {
-            engine1 = newEngine;
-            std::cout << "Updated engine for head pose successfully." << std::endl;
-        } else {
-            std::cerr << "Failed to load new engine for head pose from: " << enginePath << std::endl;
-        }
-    }
-
-    void setEngine2(const std::string& enginePath) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (enginePath == "No Eye Gaze") {
-            std::cout << "Skipping load of eye gaze engine." << std::endl;
-            if (engine2) {
-                engine2->destroy();
-                engine2 = nullptr;
-            }
-            return;
-        }
-        std::cout << "Loading new engine for eye gaze from: " << enginePath << std::endl;
-        if (engine2) {
-            engine2->destroy();
-            engine2 = nullptr;
-        }
-        ICudaEngine* newEngine = loadEngine(enginePath);
-        if (newEngine) {
-            engine2 = newEngine;
-            std::cout << "Updated engine for eye gaze successfully." << std::endl;
-        } else {
-            std::cerr << "Failed to load new engine for eye gaze from: " << enginePath << std::endl;
-        }
-    }
-
-    std::vector<float> inferHeadPose(const cv::Mat& croppedFace) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (!engine1) {
-            std::cerr << "Head pose engine not loaded, using default values." << std::endl;
-            return std::vector<float>(9, -100);
-        }
-
-        size_t memUsageBefore = getHostMemoryUsage();
-        CPUUsage cpuUsageBefore = getCPUUsage();
-
-        // Preprocessing
-        cv::Mat resizedImage;
-        cv::resize(croppedFace, resizedImage, cv::Size(224, 224));
-        resizedImage.convertTo(resizedImage, CV_32F);
-        cv::cvtColor(resizedImage, resizedImage, cv::COLOR_BGR2RGB);
-
-        std::vector<float> mean = {0.485, 0.456, 0.406};
-        std::vector<float> std = {0.229, 0.224, 0.225};
-        for (int c = 0; c < 3; ++c) {
-            resizedImage.forEach<cv::Vec3f>([&mean, &std, c](cv::Vec3f &pixel, const int* position) -> void {
-                pixel[c] = (pixel[c] / 255.0 - mean[c]) / std[c];
-            });
-        }
-
-        // Allocate GPU buffers
-        int batchSize = 1;
-        int inputSize = 1 * 3 * 224 * 224;
-        int outputSize = 9;
-        void* gpuInputBuffer;
-        void* gpuOutputBuffer;
-        cudaMalloc(&gpuInputBuffer, batchSize * inputSize * sizeof(float));
-        cudaMalloc(&gpuOutputBuffer, batchSize * outputSize * sizeof(float));
-
-        size_t freeMemBefore, totalMemBefore, freeMemAfter, totalMemAfter;
-        cudaMemGetInfo(&freeMemBefore, &totalMemBefore); // Get free memory before inference
-
-        // Copy data to GPU
-        cudaMemcpy(gpuInputBuffer, resizedImage.ptr<float>(), inputSize * sizeof(float), cudaMemcpyHostToDevice);
-
-        // Execute model
-        IExecutionContext* context = engine1->createExecutionContext();
-        void* buffers[] = {gpuInputBuffer, gpuOutputBuffer};
-        context->executeV2(buffers);
-
-        // Retrieve results
-        std::vector<float> results(outputSize);
-        cudaMemcpy(results.data(), gpuOutputBuffer, outputSize * sizeof(float), cudaMemcpyDeviceToHost);
-
-        cudaMemGetInfo(&freeMemAfter, &totalMemAfter); // Get free memory after inference
-        size_t usedMemDuringInference = (freeMemBefore - freeMemAfter);
-        if (usedMemDuringInference > peakHeadPoseGpuMemoryUsage) {
-            peakHeadPoseGpuMemoryUsage = usedMemDuringInference;
-        }
-
-        size_t memUsageAfter = getHostMemoryUsage();
-        size_t memUsageDelta = memUsageAfter - memUsageBefore;
-        totalCpuMemoryUsageHeadPose += memUsageDelta;
-        headPoseInferenceCount++;
-
-        CPUUsage cpuUsageAfter = getCPUUsage();
-        double cpuUsage = calculateCPUUsage(cpuUsageBefore, cpuUsageAfter);
-        totalCpuUsageHeadPose += cpuUsage;
-
-        // Cleanup
-        cudaFree(gpuInputBuffer);
-        cudaFree(gpuOutputBuffer);
-        context->destroy();
-
-        return results;
-    }
-
-    std::vector<float> inferEyeGaze(const cv::Mat& croppedFace) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (!engine2) {
-            std::cerr << "Eye gaze engine not loaded, using default values." << std::endl;
-            return std::vector<float>(9, -100);
-        }
-
-        size_t memUsageBefore = getHostMemoryUsage();
-        CPUUsage cpuUsageBefore = getCPUUsage();
-
-        // Preprocessing
-        cv::Mat resizedImage;
-        cv::resize(croppedFace, resizedImage, cv::Size(224, 224));
-        resizedImage.convertTo(resizedImage, CV_32F);
-        cv::cvtColor(resizedImage, resizedImage, cv::COLOR_BGR2RGB);
-
-        std::vector<float> meanValues = {0.485, 0.456, 0.406};
-        std::vector<float> stdDevs = {0.229, 0.224, 0.225};
-        for (int c = 0; c < 3; ++c) {
-            resizedImage.forEach<cv::Vec3f>([&meanValues, &stdDevs, c](cv::Vec3f &pixel, const int* position) -> void {
-                pixel[c] = (pixel[c] / 255.0 - meanValues[c]) / stdDevs[c];
-            });
-        }
-
-        // Allocate GPU buffers
-        int batchSize = 1;
-        int inputSize = 1 * 3 * 224 * 224;
-        int outputSize = 9;
-        void* gpuInputBuffer;
-        void* gpuOutputBuffer;
-        cudaMalloc(&gpuInputBuffer, batchSize * inputSize * sizeof(float));
-        cudaMalloc(&gpuOutputBuffer, batchSize * outputSize * sizeof(float));
-
-        size_t freeMemBefore, totalMemBefore, freeMemAfter, totalMemAfter;
-        cudaMemGetInfo(&freeMemBefore, &totalMemBefore); // Get free memory before inference
-
-        // Copy data to GPU
-        cudaMemcpy(gpuInputBuffer, resizedImage.ptr<float>(), inputSize * sizeof(float), cudaMemcpyHostToDevice);
-
-        // Execute model
-        IExecutionContext* context = engine2->createExecutionContext();
-        void* buffers[] = {gpuInputBuffer, gpuOutputBuffer};
-        context->executeV2(buffers);
-
-        // Retrieve results
-        std::vector<float> results(outputSize);
-        cudaMemcpy(results.data(), gpuOutputBuffer, outputSize * sizeof(float), cudaMemcpyDeviceToHost);
-
-        cudaMemGetInfo(&freeMemAfter, &totalMemAfter); // Get free memory after inference
-        size_t usedMemDuringInference = (freeMemBefore - freeMemAfter);
-        if (usedMemDuringInference > peakEyeGazeGpuMemoryUsage) {
-            peakEyeGazeGpuMemoryUsage = usedMemDuringInference;
-        }
-
-        size_t memUsageAfter = getHostMemoryUsage();
-        size_t memUsageDelta = memUsageAfter - memUsageBefore;
-        totalCpuMemoryUsageEyeGaze += memUsageDelta;
-        eyeGazeInferenceCount++;
-
-        CPUUsage cpuUsageAfter = getCPUUsage();
-        double cpuUsage = calculateCPUUsage(cpuUsageBefore, cpuUsageAfter);
-        totalCpuUsageEyeGaze += cpuUsage;
-
-        // Cleanup
-        cudaFree(gpuInputBuffer);
-        cudaFree(gpuOutputBuffer);
-        context->destroy();
-
-        return results;
-    }
-
-    size_t getPeakHeadPoseGpuMemoryUsage() const {
-        return peakHeadPoseGpuMemoryUsage;
-    }
-
-    size_t getPeakEyeGazeGpuMemoryUsage() const {
-        return peakEyeGazeGpuMemoryUsage;
-    }
-
-    size_t gettotalCpuMemoryUsageHeadPose() const {
-        return totalCpuMemoryUsageHeadPose;
-    }
-
-    size_t gettotalCpuMemoryUsageEyeGaze() const {
-        return totalCpuMemoryUsageEyeGaze;
-    }
-
-    size_t getheadPoseInferenceCount() const {
-        return headPoseInferenceCount;
-    }
-
-    size_t geteyeGazeInferenceCount() const {
-        return eyeGazeInferenceCount;
-    }
-
-    size_t geteyeGazeCpuUsage() const {
-        return totalCpuUsageEyeGaze;
-    }
-
-    size_t getheadPoseCpuUsage() const {
-        return totalCpuUsageHeadPose;
-    }
-
-    void resetPeakGpuMemoryUsage() {
-        peakHeadPoseGpuMemoryUsage = 0;
-        peakEyeGazeGpuMemoryUsage = 0;
-        totalCpuMemoryUsageHeadPose = 0;
-        totalCpuMemoryUsageEyeGaze = 0;
-        headPoseInferenceCount = 0;
-        eyeGazeInferenceCount = 0;
-        totalCpuUsageEyeGaze = 0;
-        totalCpuUsageHeadPose = 0;
-    }
-
-    size_t getHostMemoryUsage() {
-        std::ifstream statm("/proc/self/statm");
-        size_t size, resident, share, text, lib, data, dt;
-        statm >> size >> resident >> share >> text >> lib >> data >> dt;
-        statm.close();
-        return resident * sysconf(_SC_PAGESIZE); 
-    }
-
-    size_t getPageFaults() {
-        std::ifstream stat("/proc/self/stat");
-        std::string dummy;
-        size_t page_faults;
-        for (int i = 0; i < 10; ++i) stat >> dummy; 
-        stat >> page_faults; // Get the 10th field (minor page faults)
-        stat.close();
-        return page_faults;
-    }
-
-    CPUUsage getCPUUsage() {
-        std::ifstream file("/proc/stat");
-        std::string line;
-        std::getline(file, line);
-        std::istringstream ss(line);
-        std::string cpu;
-        long user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice;
-        ss >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal >> guest >> guest_nice;
-        file.close();
-
-        long idleTime = idle + iowait;
-        long totalTime = user + nice + system + idle + iowait + irq + softirq + steal;
-
-        return {idleTime, totalTime};
-    }
-
-    double calculateCPUUsage(const CPUUsage& prev, const CPUUsage& curr) {
-        long totalDiff = curr.totalTime - prev.totalTime;
-        long idleDiff = curr.idleTime - prev.idleTime;
-        return 100.0 * (totalDiff - idleDiff) / totalDiff;
-    }
-
-    ~TRTEngineSingleton() {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (engine1) {
-            engine1->destroy();
-            engine1 = nullptr;
-        }
-        if (engine2) {
-            engine2->destroy();
-            engine2 = nullptr;
-        }
-    }
-
-private:
-    ICudaEngine* loadEngine(const std::string& engineFile) {
-        std::ifstream file(engineFile, std::ios::binary);
-        if (!file.is_open()) {
-            std::cerr << "Error opening engine file" << std::endl;
-            return nullptr;
-        }
-
-        std::vector<char> buffer(std::istreambuf_iterator<char>(file), {});
-        file.close();
-
-        IRuntime* runtime = createInferRuntime(gLogger);
-        if (!runtime) {
-            std::cerr << "Failed to create InferRuntime" << std::endl;
-            return nullptr;
-        }
-
-        return runtime->deserializeCudaEngine(buffer.data(), buffer.size(), nullptr);
-    }
-};
-
-std::mutex TRTEngineSingleton::mtx;
-
-
-#endif // INFER_H
-
+#ifndef INFER_H
+#define INFER_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include "preprocess.h"
+#include "inferencesession.h"
+#include "inferencebackend.h"
+#include "modelcache.h"
+#include "mappedfile.h"
+#include "resourcesampler.h"
+#include "batchscheduler.h"
+#ifndef DMS_CPU_ONLY
+#include <NvInfer.h>
+#include <cuda_runtime_api.h>
+#include <cuda_runtime.h>
+#endif
+
+#ifndef DMS_CPU_ONLY
+using namespace nvinfer1;
+
+class Logger : public ILogger {
+    void log(Severity severity, const char* msg) noexcept override {
+        if (severity != Severity::kINFO) std::cout << msg << std::endl;
+    }
+};
+// One per translation unit that includes this header
+static Logger gLogger;
+#endif
+
+/* Number of values produced by the head pose and eye gaze engines */
+#define ENGINE_OUTPUT_SIZE      9
+
+#ifndef DMS_CPU_ONLY
+// TensorRT side of an InferenceSession, owns one execution context of the engine and its own
+// CUDA stream, so sessions of different engines can run on the GPU at the same time
+class TRTSessionBackend : public ISessionBackend {
+public:
+    explicit TRTSessionBackend(ICudaEngine* engine) : context(engine->createExecutionContext()), stream(nullptr) {
+        if (cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) != cudaSuccess) {
+            std::cerr << "Failed to create CUDA stream" << std::endl;
+            stream = nullptr;
+        }
+    }
+
+    ~TRTSessionBackend() override {
+        if (context) {
+            context->destroy();
+        }
+        if (stream) {
+            cudaStreamDestroy(stream);
+        }
+    }
+
+    void* allocateDevice(size_t bytes) override {
+        void* buffer = nullptr;
+        return cudaMalloc(&buffer, bytes) == cudaSuccess ? buffer : nullptr;
+    }
+
+    void freeDevice(void* buffer) override {
+        cudaFree(buffer);
+    }
+
+    bool copyToDevice(void* dst, const void* src, size_t bytes) override {
+        return cudaMemcpyAsync(dst, src, bytes, cudaMemcpyHostToDevice, stream) == cudaSuccess;
+    }
+
+    // Last step of a run, waits for this stream only
+    bool copyToHost(void* dst, const void* src, size_t bytes) override {
+        return cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDeviceToHost, stream) == cudaSuccess &&
+               cudaStreamSynchronize(stream) == cudaSuccess;
+    }
+
+    bool execute(void** bindings) override {
+        return context && stream && context->enqueueV2(bindings, stream, nullptr);
+    }
+
+private:
+    IExecutionContext* context;
+    cudaStream_t stream;
+};
+
+// A deserialized TensorRT engine with its session. Keeps the runtime that created it alive
+class TRTInferenceBackend : public IInferenceBackend {
+public:
+    TRTInferenceBackend(const std::string& engineFile, std::shared_ptr<IRuntime> runtime)
+        : runtime(runtime), engineBytes(0) {
+        engine = loadEngine(engineFile, *runtime, engineBytes);
+        if (engine) {
+            std::unique_ptr<ISessionBackend> backend(new TRTSessionBackend(engine));
+            session.reset(new InferenceSession(std::move(backend),
+                3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT, ENGINE_OUTPUT_SIZE));
+        }
+    }
+
+    ~TRTInferenceBackend() override {
+        // The session's context has to go before its engine
+        session.reset();
+        if (engine) {
+            engine->destroy();
+        }
+    }
+
+    bool isLoaded() const { return engine && session; }
+
+    bool infer(const float* input, std::vector<float>& output) override {
+        // Upload, execute and download on the session's preallocated buffers
+        output.resize(session->getOutputSize());
+        return session->run(input, output.data());
+    }
+
+    std::string getName() const override {
+        return "TensorRT";
+    }
+
+    // Serialized weights plus the execution context's activation memory and I/O buffers
+    size_t getResidentBytes() const override {
+        if (!engine) {
+            return 0;
+        }
+        return engineBytes + engine->getDeviceMemorySize() +
+               (3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT + ENGINE_OUTPUT_SIZE) * sizeof(float);
+    }
+
+private:
+    std::shared_ptr<IRuntime> runtime;
+    ICudaEngine* engine;
+    size_t engineBytes; // Size of the serialized engine
+    std::unique_ptr<InferenceSession> session;
+
+    // Deserialize straight from the mapped file, no copy of the blob on the heap
+    static ICudaEngine* loadEngine(const std::string& engineFile, IRuntime& runtime, size_t& engineBytes) {
+        MappedFile file(engineFile);
+        if (!file.isOpen()) {
+            std::cerr << "Error opening engine file" << std::endl;
+            return nullptr;
+        }
+        engineBytes = file.getSize();
+        return runtime.deserializeCudaEngine(file.getData(), file.getSize(), nullptr);
+    }
+};
+#endif
+
+class TRTEngineSingleton {
+public:
+    // Creates the model for an engine path on a backend, nullptr if it fails to load
+    typedef std::function<std::unique_ptr<IInferenceBackend>(const std::string&, InferenceBackendType)> ModelFactory;
+
+private:
+    static TRTEngineSingleton* instance;
+    static std::mutex mtx; // Mutex for thread safety of getInstance()
+
+    // One lock per model, head pose and eye gaze inference run concurrently
+    std::mutex headPoseMtx;
+    std::mutex eyeGazeMtx;
+
+    // Models currently serving, read and replaced only through std::atomic_load/atomic_exchange.
+    // An inference holds its own reference, so a swapped out model stays alive until it finishes
+    std::shared_ptr<IInferenceBackend> headPoseBackend;
+    std::shared_ptr<IInferenceBackend> eyeGazeBackend;
+
+    // Background loads, one per model. loaderMtx guards the threads, the paths and backendType
+    std::mutex loaderMtx;
+    std::thread headPoseLoader;
+    std::thread eyeGazeLoader;
+    std::thread preloader;
+
+#ifndef DMS_CPU_ONLY
+    // One TensorRT runtime for every engine, created on the first load. Declared before the cache
+    // so engines still cached at shutdown go first
+    std::mutex runtimeMtx;
+    std::shared_ptr<IRuntime> runtime;
+#endif
+
+    // Every loaded model stays resident here up to the budget, switching back to one is a lookup
+    ModelCache modelCache;
+
+    // Engine paths of the loaded models, kept to reload them when the backend changes
+    std::string headPosePath;
+    std::string eyeGazePath;
+    InferenceBackendType backendType;
+    ModelFactory modelFactory; // Replaces createBackend's TensorRT/CPU models when set
+
+    // Swap latency, from the request to the handoff, loading and warm-up included
+    std::mutex swapMetricsMtx;
+    size_t swapCount = 0;
+    double totalSwapLatency = 0.0;
+    double maxSwapLatency = 0.0;
+
+    // Model loads from disk, deserialization and warm-up included
+    size_t loadCount = 0;
+    double totalLoadTime = 0.0;
+    double maxLoadTime = 0.0;
+
+    size_t headPoseInferenceCount = 0;
+    size_t eyeGazeInferenceCount = 0;
+
+    // When each model ran, matched to the resource samples when the metrics are logged
+    InferenceWindowLog headPoseWindows;
+    InferenceWindowLog eyeGazeWindows;
+
+    // Host and device memory, CPU and page faults, sampled off the inference path
+    ResourceSampler resourceSampler;
+
+    // Micro-batching of concurrent requests per model, read with std::atomic_load. Empty while
+    // batching is off, then every request runs on its own
+    std::shared_ptr<BatchScheduler> headPoseBatcher;
+    std::shared_ptr<BatchScheduler> eyeGazeBatcher;
+
+    TRTEngineSingleton() : modelCache(static_cast<size_t>(MODEL_CACHE_BUDGET_MB) * 1024 * 1024),
+                           resourceSampler(&TRTEngineSingleton::getUsedGpuMemory) {
+#ifdef DMS_CPU_ONLY
+        backendType = InferenceBackendType::CPU;
+#else
+        backendType = InferenceBackendType::TensorRT;
+#endif
+        // Load engines if you want it to be loaded at startup using loadEngines() method
+    }
+
+public:
+    static TRTEngineSingleton* getInstance() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!instance) {
+            instance = new TRTEngineSingleton();
+        }
+        return instance;
+    }
+
+    void loadEngines() {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        headPosePath = "/home/dms/DMS/ModularCode/include/Ay.engine";
+        eyeGazePath = "/home/dms/DMS/ModularCode/modelconfigs/mobilenetv3_engine.engine";
+        // Nothing is serving yet, so load in place
+        swapModel(&headPoseBackend, headPosePath, backendType, "head pose");
+        swapModel(&eyeGazeBackend, eyeGazePath, backendType, "eye gaze");
+        std::cout << "Loaded engines successfully." << std::endl;
+        if (!std::atomic_load(&headPoseBackend) || !std::atomic_load(&eyeGazeBackend)) {
+            std::cerr << "Failed to load one or both engines" << std::endl;
+        }
+    }
+
+    // Returns at once, the current head pose engine keeps serving until the new one is loaded
+    void setEngine1(const std::string& enginePath) {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        if (enginePath == "No Head Pose") {
+            std::cout << "Skipping load of head pose engine." << std::endl;
+            headPosePath.clear();
+        } else {
+            std::cout << "Loading new engine for head pose from: " << enginePath << std::endl;
+            headPosePath = enginePath;
+        }
+        startLoader(headPoseLoader, &headPoseBackend, headPosePath, "head pose");
+    }
+
+    // Returns at once, the current eye gaze engine keeps serving until the new one is loaded
+    void setEngine2(const std::string& enginePath) {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        if (enginePath == "No Eye Gaze") {
+            std::cout << "Skipping load of eye gaze engine." << std::endl;
+            eyeGazePath.clear();
+        } else {
+            std::cout << "Loading new engine for eye gaze from: " << enginePath << std::endl;
+            eyeGazePath = enginePath;
+        }
+        startLoader(eyeGazeLoader, &eyeGazeBackend, eyeGazePath, "eye gaze");
+    }
+
+    // Run both models on TensorRT or on the CPU, the loaded models are reloaded on the new backend
+    void setBackend(InferenceBackendType type) {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+#ifdef DMS_CPU_ONLY
+        if (type == InferenceBackendType::TensorRT) {
+            std::cerr << "Built without TensorRT, staying on the CPU backend." << std::endl;
+            return;
+        }
+#endif
+        backendType = type;
+        startLoader(headPoseLoader, &headPoseBackend, headPosePath, "head pose");
+        startLoader(eyeGazeLoader, &eyeGazeBackend, eyeGazePath, "eye gaze");
+        std::cout << "Inference backend set to "
+                  << (type == InferenceBackendType::CPU ? "CPU" : "TensorRT") << std::endl;
+    }
+
+    // Create models through 'factory' instead of loading engine or ONNX files, so benchmarks and
+    // tests can run the singleton on MockInferenceBackend. Call before the first load
+    void setModelFactory(const ModelFactory& factory) {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        modelFactory = factory;
+    }
+
+    // Load models into the cache in the background, on the current backend, without serving them
+    void preloadModels(const std::vector<std::string>& headPosePaths, const std::vector<std::string>& eyeGazePaths) {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        if (preloader.joinable()) {
+            preloader.join();
+        }
+        InferenceBackendType type = backendType;
+        preloader = std::thread([this, headPosePaths, eyeGazePaths, type]() {
+            for (const auto& path : headPosePaths) {
+                if (!getCachedModel("head pose", path, type)) {
+                    std::cerr << "Failed to preload head pose engine: " << path << std::endl;
+                }
+            }
+            for (const auto& path : eyeGazePaths) {
+                if (!getCachedModel("eye gaze", path, type)) {
+                    std::cerr << "Failed to preload eye gaze engine: " << path << std::endl;
+                }
+            }
+            std::cout << "Preloaded models, cache holds "
+                      << static_cast<double>(modelCache.getResidentBytes()) / (1024 * 1024) << " MB." << std::endl;
+        });
+    }
+
+    void setModelCacheBudget(size_t budgetMB) {
+        modelCache.setBudget(budgetMB * 1024 * 1024);
+    }
+
+    void logModelCacheMetrics(std::ostream& out) {
+        modelCache.logCacheMetrics(out);
+    }
+
+    // Batch up to 'maxBatch' concurrent requests per model, a batch waits at most 'deadlineUs' for more.
+    // A maxBatch of 0 or 1 turns batching off. The AI loop submits one request per model per frame,
+    // so a batch only fills with several submitting streams; with one, every request waits out the deadline
+    void setBatching(size_t maxBatch, int deadlineUs) {
+        std::shared_ptr<BatchScheduler> headPose, eyeGaze;
+        if (maxBatch > 1) {
+            const size_t inputSize = 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT;
+            const std::chrono::microseconds deadline(std::max(deadlineUs, 0));
+            headPose = std::make_shared<BatchScheduler>([this](const float* inputs, size_t count, std::vector<float>& outputs) {
+                return runHeadPose(inputs, count, outputs);
+            }, inputSize, maxBatch, deadline);
+            eyeGaze = std::make_shared<BatchScheduler>([this](const float* inputs, size_t count, std::vector<float>& outputs) {
+                return runEyeGaze(inputs, count, outputs);
+            }, inputSize, maxBatch, deadline);
+        }
+        // Replaced schedulers answer their pending requests before they go away
+        std::atomic_store(&headPoseBatcher, headPose);
+        std::atomic_store(&eyeGazeBatcher, eyeGaze);
+    }
+
+    std::string getHeadPoseBackendName() {
+        std::shared_ptr<IInferenceBackend> backend = std::atomic_load(&headPoseBackend);
+        return backend ? backend->getName() : "None";
+    }
+
+    std::string getEyeGazeBackendName() {
+        std::shared_ptr<IInferenceBackend> backend = std::atomic_load(&eyeGazeBackend);
+        return backend ? backend->getName() : "None";
+    }
+
+    std::vector<float> inferHeadPose(const cv::Mat& croppedFace) {
+        // Preprocessing, one fused pass into the planar tensor the engine expects
+        std::vector<float> input(3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT);
+        preprocessToCHW(croppedFace, cv::Size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT), input.data());
+        return inferHeadPose(input.data());
+    }
+
+    // Run on an already preprocessed 3 x 224 x 224 planar tensor, see PreprocessCache
+    std::vector<float> inferHeadPose(const float* input) {
+        // With batching on, concurrent requests share one batched call
+        std::shared_ptr<BatchScheduler> batcher = std::atomic_load(&headPoseBatcher);
+        std::vector<float> results;
+        bool ok = batcher ? !(results = batcher->submit(input).get()).empty()
+                          : runHeadPose(input, 1, results);
+        if (!ok) {
+            std::cerr << "Head pose engine not loaded, using default values." << std::endl;
+            return std::vector<float>(9, -100);
+        }
+        return results;
+    }
+
+    std::vector<float> inferEyeGaze(const cv::Mat& croppedFace) {
+        // Preprocessing, one fused pass into the planar tensor the engine expects
+        std::vector<float> input(3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT);
+        preprocessToCHW(croppedFace, cv::Size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT), input.data());
+        return inferEyeGaze(input.data());
+    }
+
+    // Run on an already preprocessed 3 x 224 x 224 planar tensor, see PreprocessCache
+    std::vector<float> inferEyeGaze(const float* input) {
+        // With batching on, concurrent requests share one batched call
+        std::shared_ptr<BatchScheduler> batcher = std::atomic_load(&eyeGazeBatcher);
+        std::vector<float> results;
+        bool ok = batcher ? !(results = batcher->submit(input).get()).empty()
+                          : runEyeGaze(input, 1, results);
+        if (!ok) {
+            std::cerr << "Eye gaze engine not loaded, using default values." << std::endl;
+            return std::vector<float>(9, -100);
+        }
+        return results;
+    }
+
+    size_t getheadPoseInferenceCount() const {
+        return headPoseInferenceCount;
+    }
+
+    size_t geteyeGazeInferenceCount() const {
+        return eyeGazeInferenceCount;
+    }
+
+    // Resources sampled while head pose was running, since the last reset
+    ResourceSummary getHeadPoseResourceSummary() {
+        std::vector<InferenceWindow> windows;
+        {
+            std::lock_guard<std::mutex> lock(headPoseMtx);
+            windows = headPoseWindows.ordered();
+        }
+        return resourceSampler.summarize(windows);
+    }
+
+    // Resources sampled while eye gaze was running, since the last reset
+    ResourceSummary getEyeGazeResourceSummary() {
+        std::vector<InferenceWindow> windows;
+        {
+            std::lock_guard<std::mutex> lock(eyeGazeMtx);
+            windows = eyeGazeWindows.ordered();
+        }
+        return resourceSampler.summarize(windows);
+    }
+
+    ResourceSampler& getResourceSampler() {
+        return resourceSampler;
+    }
+
+    size_t getSwapCount() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return swapCount;
+    }
+
+    double getAverageSwapLatency() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return swapCount > 0 ? totalSwapLatency / swapCount : 0.0;
+    }
+
+    double getMaxSwapLatency() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return maxSwapLatency;
+    }
+
+    size_t getLoadCount() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return loadCount;
+    }
+
+    double getAverageLoadTime() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return loadCount > 0 ? totalLoadTime / loadCount : 0.0;
+    }
+
+    double getMaxLoadTime() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        return maxLoadTime;
+    }
+
+    void resetSwapMetrics() {
+        std::lock_guard<std::mutex> lock(swapMetricsMtx);
+        swapCount = 0;
+        totalSwapLatency = 0.0;
+        maxSwapLatency = 0.0;
+        loadCount = 0;
+        totalLoadTime = 0.0;
+        maxLoadTime = 0.0;
+    }
+
+    void resetPeakGpuMemoryUsage() {
+        {
+            std::lock_guard<std::mutex> lock(headPoseMtx);
+            headPoseInferenceCount = 0;
+            headPoseWindows.clear();
+        }
+        std::lock_guard<std::mutex> lock(eyeGazeMtx);
+        eyeGazeInferenceCount = 0;
+        eyeGazeWindows.clear();
+    }
+
+    ~TRTEngineSingleton() {
+        std::lock_guard<std::mutex> lock(loaderMtx);
+        if (headPoseLoader.joinable()) {
+            headPoseLoader.join();
+        }
+        if (eyeGazeLoader.joinable()) {
+            eyeGazeLoader.join();
+        }
+        if (preloader.joinable()) {
+            preloader.join();
+        }
+        std::atomic_store(&headPoseBatcher, std::shared_ptr<BatchScheduler>());
+        std::atomic_store(&eyeGazeBatcher, std::shared_ptr<BatchScheduler>());
+        std::atomic_store(&headPoseBackend, std::shared_ptr<IInferenceBackend>());
+        std::atomic_store(&eyeGazeBackend, std::shared_ptr<IInferenceBackend>());
+    }
+
+private:
+    // Run 'count' contiguous head pose inputs on the serving model in one call
+    bool runHeadPose(const float* inputs, size_t count, std::vector<float>& outputs) {
+        std::shared_ptr<IInferenceBackend> backend = std::atomic_load(&headPoseBackend);
+        if (!backend) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(headPoseMtx);
+        auto start = std::chrono::steady_clock::now();
+        bool ok = backend->inferBatch(inputs, count, 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT, outputs);
+        headPoseWindows.add(start, std::chrono::steady_clock::now());
+        headPoseInferenceCount += count;
+        return ok;
+    }
+
+    // Run 'count' contiguous eye gaze inputs on the serving model in one call
+    bool runEyeGaze(const float* inputs, size_t count, std::vector<float>& outputs) {
+        std::shared_ptr<IInferenceBackend> backend = std::atomic_load(&eyeGazeBackend);
+        if (!backend) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(eyeGazeMtx);
+        auto start = std::chrono::steady_clock::now();
+        bool ok = backend->inferBatch(inputs, count, 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT, outputs);
+        eyeGazeWindows.add(start, std::chrono::steady_clock::now());
+        eyeGazeInferenceCount += count;
+        return ok;
+    }
+
+    // Replace the model in 'slot' on a background thread, called with loaderMtx held.
+    // Loads of the same model run one after another
+    void startLoader(std::thread& loader, std::shared_ptr<IInferenceBackend>* slot,
+                     const std::string& enginePath, const std::string& name) {
+        if (loader.joinable()) {
+            loader.join();
+        }
+        loader = std::thread(&TRTEngineSingleton::swapModel, this, slot, enginePath, backendType, name);
+    }
+
+    // Load and warm up the model for 'enginePath', then hand it over to 'slot' in one atomic swap.
+    // An empty path unloads the model. The old model is not waited for: the cache usually keeps it,
+    // otherwise it goes with the last inference still running on it
+    void swapModel(std::shared_ptr<IInferenceBackend>* slot, std::string enginePath,
+                   InferenceBackendType type, std::string name) {
+        auto requested = std::chrono::steady_clock::now();
+        std::shared_ptr<IInferenceBackend> next;
+        if (!enginePath.empty()) {
+            next = getCachedModel(name, enginePath, type);
+            if (!next) {
+                std::cerr << "Failed to load new engine for " << name << " from: " << enginePath
+                          << ", keeping the current one." << std::endl;
+                return;
+            }
+        }
+
+        std::shared_ptr<IInferenceBackend> previous = std::atomic_exchange(slot, next);
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - requested).count();
+        {
+            std::lock_guard<std::mutex> lock(swapMetricsMtx);
+            swapCount++;
+            totalSwapLatency += latency;
+            maxSwapLatency = std::max(maxSwapLatency, latency);
+        }
+        std::cout << "Updated engine for " << name << " successfully in " << latency << " ms." << std::endl;
+    }
+
+    // Model for 'enginePath' from the cache, loaded and warmed up on a miss. Keys include the model
+    // slot, so head pose and eye gaze never share one execution context
+    std::shared_ptr<IInferenceBackend> getCachedModel(const std::string& name, const std::string& enginePath,
+                                                      InferenceBackendType type) {
+        std::string key = name + " | " + (type == InferenceBackendType::CPU ? "CPU" : "TensorRT") + " | " + enginePath;
+        return modelCache.getOrLoad(key, [this, &enginePath, type]() {
+            auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<IInferenceBackend> model(createBackend(enginePath, type));
+            if (model) {
+                // The first run initializes lazily allocated state, keep it off the frame path
+                std::vector<float> input(3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT, 0.0f), output;
+                model->infer(input.data(), output);
+
+                double loadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::lock_guard<std::mutex> lock(swapMetricsMtx);
+                loadCount++;
+                totalLoadTime += loadTime;
+                maxLoadTime = std::max(maxLoadTime, loadTime);
+                std::cout << "Loaded " << enginePath << " in " << loadTime << " ms." << std::endl;
+            }
+            return model;
+        });
+    }
+
+    // Model for 'enginePath' on the given backend, nullptr if it fails to load.
+    // The CPU backend reads the .onnx export stored next to the engine file
+    std::unique_ptr<IInferenceBackend> createBackend(const std::string& enginePath, InferenceBackendType type) {
+        if (modelFactory) {
+            return modelFactory(enginePath, type);
+        }
+        if (type == InferenceBackendType::CPU) {
+            std::unique_ptr<CPUInferenceBackend> backend(new CPUInferenceBackend(onnxPathForEngine(enginePath), "",
+                cv::Size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT), CPU_INFERENCE_THREADS));
+            if (!backend->isLoaded()) {
+                return nullptr;
+            }
+            return std::move(backend);
+        }
+#ifndef DMS_CPU_ONLY
+        std::shared_ptr<IRuntime> shared = getRuntime();
+        if (!shared) {
+            return nullptr;
+        }
+        std::unique_ptr<TRTInferenceBackend> backend(new TRTInferenceBackend(enginePath, shared));
+        if (!backend->isLoaded()) {
+            return nullptr;
+        }
+        return std::move(backend);
+#else
+        return nullptr;
+#endif
+    }
+
+#ifndef DMS_CPU_ONLY
+    // The shared runtime, nullptr if it can't be created
+    std::shared_ptr<IRuntime> getRuntime() {
+        std::lock_guard<std::mutex> lock(runtimeMtx);
+        if (!runtime) {
+            IRuntime* created = createInferRuntime(gLogger);
+            if (!created) {
+                std::cerr << "Failed to create InferRuntime" << std::endl;
+                return nullptr;
+            }
+            runtime.reset(created, [](IRuntime* r) { r->destroy(); });
+        }
+        return runtime;
+    }
+#endif
+
+    // GPU memory in use in bytes, 0 without CUDA. Only called by the resource sampler
+    static size_t getUsedGpuMemory() {
+#ifndef DMS_CPU_ONLY
+        size_t freeMem = 0, totalMem = 0;
+        cudaMemGetInfo(&freeMem, &totalMem);
+        return totalMem - freeMem;
+#else
+        return 0;
+#endif
+    }
+};
+
+
+#endif // INFER_H
+
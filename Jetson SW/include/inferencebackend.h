@@ -0,0 +1,81 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/* Threads cv::dnn may use for the CPU backend, 0 lets OpenCV decide */
+#define CPU_INFERENCE_THREADS   4
+
+// Where the head pose and eye gaze models run
+enum class InferenceBackendType {
+    TensorRT,  // Serialized .engine files on the GPU
+    CPU        // ONNX models next to the engine files, run through cv::dnn
+};
+
+// A loaded model mapping one preprocessed planar CHW float tensor to its outputs.
+// TRTInferenceBackend (infer.h) and CPUInferenceBackend implement it
+class IInferenceBackend {
+public:
+    virtual ~IInferenceBackend() {}
+
+    // 'input' holds 3 x height x width floats, 'output' is resized to the model's output size
+    virtual bool infer(const float* input, std::vector<float>& output) = 0;
+
+    // 'count' contiguous inputs of 'inputSize' floats, 'outputs' gets their outputs back to back.
+    // Runs them one at a time unless the backend can execute a real batch
+    virtual bool inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs);
+
+    // Name written to the benchmark logs
+    virtual std::string getName() const = 0;
+
+    // Approximate memory the loaded model keeps resident, weights plus working buffers
+    virtual size_t getResidentBytes() const = 0;
+};
+
+// Runs an ONNX model, or a Darknet cfg/weights pair, on the CPU through cv::dnn
+class CPUInferenceBackend : public IInferenceBackend {
+public:
+    // 'weights' is only used for Darknet models. 'threads' is applied to OpenCV's thread pool,
+    // which is process wide
+    CPUInferenceBackend(const std::string& model, const std::string& weights, cv::Size inputSize, int threads);
+
+    bool isLoaded() const { return !net.empty(); }
+
+    bool infer(const float* input, std::vector<float>& output) override;
+
+    // One N x 3 x H x W forward pass, falls back to single runs for models exported with a fixed batch
+    bool inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs) override;
+
+    std::string getName() const override;
+    size_t getResidentBytes() const override;
+
+private:
+    cv::dnn::Net net;
+    cv::Size inputSize;
+    int threads;
+    size_t modelBytes = 0; // Size of the model files, cv::dnn keeps the weights in memory
+    bool fixedBatch = false; // The model rejected a batch larger than one
+};
+
+// Stand-in model for benchmarks without a model file. Every output is the mean of the input, and each
+// call sleeps a fixed launch overhead plus a cost per input, like a GPU launch followed by the work
+class MockInferenceBackend : public IInferenceBackend {
+public:
+    // inputSize and outputSize are in floats
+    MockInferenceBackend(size_t inputSize, size_t outputSize, int launchOverheadUs, int perInputUs);
+
+    bool infer(const float* input, std::vector<float>& output) override;
+    bool inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs) override;
+    std::string getName() const override;
+    size_t getResidentBytes() const override { return 0; }
+
+private:
+    size_t inputSize;
+    size_t outputSize;
+    int launchOverheadUs;
+    int perInputUs;
+};
+
+// CPU model path for a TensorRT engine path: the .onnx file with the same name
+std::string onnxPathForEngine(const std::string& enginePath);
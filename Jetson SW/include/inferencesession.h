@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+// Device side of an inference session: memory and execution for one loaded engine.
+// TRTSessionBackend (infer.h) runs on the GPU, MockSessionBackend runs on the CPU
+class ISessionBackend {
+public:
+    virtual ~ISessionBackend() {}
+
+    virtual void* allocateDevice(size_t bytes) = 0;
+    virtual void freeDevice(void* buffer) = 0;
+    virtual bool copyToDevice(void* dst, const void* src, size_t bytes) = 0;
+    virtual bool copyToHost(void* dst, const void* src, size_t bytes) = 0;
+
+    // Run the model, bindings are {input, output} device buffers
+    virtual bool execute(void** bindings) = 0;
+};
+
+// One loaded engine with its input and output buffers allocated once. Every run() reuses them,
+// so steady-state inference performs no allocation
+class InferenceSession {
+public:
+    // inputSize and outputSize are in floats
+    InferenceSession(std::unique_ptr<ISessionBackend> backend, size_t inputSize, size_t outputSize);
+    ~InferenceSession();
+
+    // Upload 'input' (inputSize floats), execute and download into 'output' (outputSize floats)
+    bool run(const float* input, float* output);
+
+    size_t getInputSize() const { return inputSize; }
+    size_t getOutputSize() const { return outputSize; }
+    size_t getRunCount() const { return runCount; }
+
+private:
+    std::unique_ptr<ISessionBackend> backend;
+    size_t inputSize;
+    size_t outputSize;
+    void* deviceInput;
+    void* deviceOutput;
+    size_t runCount = 0;
+
+    InferenceSession(const InferenceSession&) = delete;
+    InferenceSession& operator=(const InferenceSession&) = delete;
+};
+
+// CPU stand-in for a GPU engine. "Device" buffers are host memory and execute() fills every output
+// with the mean of the input, so sessions can be exercised on a machine without a GPU.
+// Counts allocations to show they only happen when the session is created
+class MockSessionBackend : public ISessionBackend {
+public:
+    MockSessionBackend(size_t inputSize, size_t outputSize);
+
+    void* allocateDevice(size_t bytes) override;
+    void freeDevice(void* buffer) override;
+    bool copyToDevice(void* dst, const void* src, size_t bytes) override;
+    bool copyToHost(void* dst, const void* src, size_t bytes) override;
+    bool execute(void** bindings) override;
+
+    size_t getAllocationCount() const { return allocationCount; }
+    size_t getExecuteCount() const { return executeCount; }
+
+    // Make the matching calls fail until cleared, to exercise the session's error paths
+    void setFailAllocation(bool fail) { failAllocation = fail; }
+    void setFailCopy(bool fail) { failCopy = fail; }
+    void setFailExecute(bool fail) { failExecute = fail; }
+
+private:
+    size_t inputSize;
+    size_t outputSize;
+    size_t allocationCount = 0;
+    size_t executeCount = 0;
+    bool failAllocation = false;
+    bool failCopy = false;
+    bool failExecute = false;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "framepacket.h"
+
+/* Latency histogram resolution and range, samples above the range land in the last bucket */
+#define LATENCY_BUCKET_MS               0.25
+#define LATENCY_BUCKET_COUNT            4000
+
+/* Seconds between live latency dumps to the benchmark log, 0 disables them */
+#define LATENCY_LIVE_DUMP_INTERVAL_S    10
+
+// Fixed-resolution histogram of millisecond samples, percentiles are accurate to LATENCY_BUCKET_MS
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(double ms);
+
+    // Upper edge of the bucket holding the p-th fraction of samples (p in 0..1), capped at the true max
+    double percentile(double p) const;
+
+    size_t count() const { return samples; }
+    double max() const { return maxMs; }
+    double mean() const { return samples > 0 ? totalMs / samples : 0; }
+
+    void reset();
+
+private:
+    std::vector<uint32_t> buckets;
+    size_t samples;
+    double maxMs;
+    double totalMs;
+};
+
+// Aggregates the stage timestamps of every frame that reached the TCP client into per-stage and
+// end-to-end (capture to socket send) latency histograms
+class LatencyTracker {
+public:
+    enum Stage {
+        CaptureToFaceDetection,  // Camera queue wait
+        FaceDetection,
+        FaceDetectionToAI,       // Face detection queue wait
+        AIInference,
+        AIToEncode,              // Frames queue wait
+        JpegEncode,
+        SocketSend,
+        EndToEnd,                // Capture to the last byte handed to the socket
+        StageCount
+    };
+
+    LatencyTracker();
+
+    // Record a frame once it has been sent. Stages that did not run on this frame are skipped.
+    // Writes a live dump to the benchmark log every live dump interval
+    void record(const FramePacket& packet);
+
+    // Seconds between live dumps, 0 disables them
+    void setLiveDumpInterval(int seconds);
+
+    // Write p50/p90/p99/max for every stage to the benchmark log and reset the histograms
+    void logLatencyMetrics();
+
+private:
+    mutable std::mutex mtx;
+    LatencyHistogram histograms[StageCount];
+    int liveDumpIntervalS;
+    FramePacket::Clock::time_point lastDump;
+
+    void addStage(Stage stage, FramePacket::Clock::time_point start, FramePacket::Clock::time_point end);
+
+    // Append the current histograms under the given title, caller holds mtx
+    void writeMetrics(const std::string& title) const;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file, unmapped on destruction. The pages are advised as
+// sequential and needed soon, so the kernel reads ahead while the blob is consumed
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    bool isOpen() const { return data != nullptr; }
+    const char* getData() const { return static_cast<const char*>(data); }
+    size_t getSize() const { return size; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "inferencebackend.h"
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+/* Default memory budget of the model cache in MB */
+#define MODEL_CACHE_BUDGET_MB   1024
+
+// Loaded models kept resident by key, up to a memory budget. A cached model is returned in O(1);
+// the least recently used ones are evicted first once the budget is exceeded. Eviction only drops
+// the cache's reference, a model still serving or mid inference stays alive until its users let go
+class ModelCache {
+public:
+    typedef std::function<std::shared_ptr<IInferenceBackend>()> Loader;
+
+    explicit ModelCache(size_t budgetBytes);
+
+    // Cached model for 'key', or the result of 'loader' which is then cached. The loader runs
+    // without the cache lock held. Returns nullptr if the loader fails
+    std::shared_ptr<IInferenceBackend> getOrLoad(const std::string& key, const Loader& loader);
+
+    bool contains(const std::string& key) const;
+
+    void setBudget(size_t budgetBytes);
+    size_t getResidentBytes() const;
+
+    // Budget, resident memory per model and hit/miss/eviction counts, then resets the counts
+    void logCacheMetrics(std::ostream& out);
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<IInferenceBackend> model;
+        size_t bytes;
+    };
+
+    mutable std::mutex mtx;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t budget;
+    size_t resident = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+
+    // Drop least recently used models until the budget holds, called with mtx held
+    void evictLocked();
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/* Input size of the head pose and eye gaze engines */
+#define ENGINE_INPUT_WIDTH      224
+#define ENGINE_INPUT_HEIGHT     224
+
+// Resize an 8-bit BGR image to 'size' and write it as a normalized (ImageNet mean/std), planar
+// RGB float tensor: dst[0 .. w*h) is R, then G, then B. dst must hold 3 * size.area() floats.
+// The resize runs on 8-bit data, conversion, channel swap, normalization and the HWC to CHW
+// transpose are fused into one vectorized pass over the resized image.
+void preprocessToCHW(const cv::Mat& image, cv::Size size, float* dst);
+
+// Convert an 8-bit BGR image at its own size to a normalized (ImageNet mean/std) RGB CV_32FC3
+// image, in one vectorized pass. For deriving several model inputs from one conversion
+void normalizeToRGB(const cv::Mat& image, cv::Mat& dst);
+
+// Resize a normalizeToRGB image (or a region of it) to 'size' and write it as a planar RGB
+// tensor in the layout of preprocessToCHW. dst must hold 3 * size.area() floats
+void resizeToCHW(const cv::Mat& normalized, cv::Size size, float* dst);
+
+// Scalar reference of preprocessToCHW, one pixel at a time with the original formula. Used by
+// tests/test_preprocess.cpp and bench/bench_preprocess.cpp
+void preprocessToCHWReference(const cv::Mat& image, cv::Size size, float* dst);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include "preprocess.h"
+
+/* Eye gaze runs on the upper part of the face crop */
+#define EYE_GAZE_CROP_RATIO     0.55
+
+/* Number of recent face crops kept */
+#define PREPROCESS_CACHE_SIZE   4
+
+// Normalized planar RGB tensors derived from one face crop
+struct PreprocessedFace {
+    uint64_t frameId = 0;
+    cv::Rect roi;
+    std::vector<float> headPose;  // Whole crop, 3 x ENGINE_INPUT_HEIGHT x ENGINE_INPUT_WIDTH
+    std::vector<float> eyeGaze;   // Upper EYE_GAZE_CROP_RATIO of the crop, same size as headPose
+};
+
+// Converts each face crop to the normalized input of every model once. Entries are keyed by frame ID
+// and ROI, so any stage holding the packet can reuse them. AIComponent::detectAI is the only
+// consumer so far and looks each frame up once, so hits only come from stages added later
+class PreprocessCache {
+public:
+    PreprocessCache();
+
+    // Tensors for 'crop', taken from frame 'frameId' at 'roi'. Computed on a miss.
+    // The returned entry stays valid for as long as the caller holds it
+    std::shared_ptr<const PreprocessedFace> lookup(uint64_t frameId, const cv::Rect& roi, const cv::Mat& crop);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+    void resetMetrics();
+
+private:
+    mutable std::mutex mtx;
+    std::vector<std::shared_ptr<PreprocessedFace>> entries;
+    size_t next = 0; // Slot replaced by the next miss
+    size_t hits = 0;
+    size_t misses = 0;
+
+    // Fill the tensors of 'entry' from 'crop'
+    static void convert(const cv::Mat& crop, PreprocessedFace& entry);
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+/* Upper bounds (ms) of the dwell-time histogram buckets, the last bucket catches everything above */
+#define QUEUE_DWELL_BUCKETS     11
+static const double QUEUE_DWELL_BOUNDS_MS[QUEUE_DWELL_BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+// Snapshot of a queue's counters, see ThreadSafeQueue::getStats()
+struct QueueStats {
+    bool instrumented = false;   // False when built without QUEUE_INSTRUMENTATION, only depth and drops are valid
+    bool mailbox = false;        // Drops are overwrites of an unread item
+    size_t depth = 0;
+    size_t peakDepth = 0;
+    size_t droppedCount = 0;
+    size_t pushCount = 0;
+    size_t popCount = 0;
+    double pushRate = 0;         // Items per second since the last reset
+    double popRate = 0;
+    double producerWaitMs = 0;   // Total time producers spent on the lock or on a full queue
+    double consumerWaitMs = 0;   // Total time consumers spent waiting for an item
+    size_t dwellHistogram[QUEUE_DWELL_BUCKETS] = {0};  // How long popped items sat in the queue
+};
+
+#ifdef QUEUE_INSTRUMENTATION
+
+// Counters behind QueueStats. All updates are relaxed atomics so the producer and consumer of a
+// lock-free link can record without sharing a lock
+class QueueInstrumentation {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point Stamp;
+
+    QueueInstrumentation() {
+        reset();
+    }
+
+    Stamp now() const {
+        return Clock::now();
+    }
+
+    void onPush(size_t depth, Stamp waitStart) {
+        pushCount.fetch_add(1, std::memory_order_relaxed);
+        producerWaitNs.fetch_add(elapsedNs(waitStart), std::memory_order_relaxed);
+        size_t peak = peakDepth.load(std::memory_order_relaxed);
+        while (depth > peak && !peakDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onPop(Stamp enqueued, Stamp waitStart) {
+        const Stamp popped = now();
+        popCount.fetch_add(1, std::memory_order_relaxed);
+        consumerWaitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(popped - waitStart).count(),
+                                 std::memory_order_relaxed);
+        const double dwellMs = std::chrono::duration<double, std::milli>(popped - enqueued).count();
+        size_t bucket = 0;
+        while (bucket < QUEUE_DWELL_BUCKETS - 1 && dwellMs > QUEUE_DWELL_BOUNDS_MS[bucket]) {
+            ++bucket;
+        }
+        dwellHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void fill(QueueStats& stats) const {
+        const double seconds = std::chrono::duration<double>(now() - resetTime.load()).count();
+        stats.instrumented = true;
+        stats.peakDepth = peakDepth.load(std::memory_order_relaxed);
+        stats.pushCount = pushCount.load(std::memory_order_relaxed);
+        stats.popCount = popCount.load(std::memory_order_relaxed);
+        stats.pushRate = seconds > 0 ? stats.pushCount / seconds : 0;
+        stats.popRate = seconds > 0 ? stats.popCount / seconds : 0;
+        stats.producerWaitMs = producerWaitNs.load(std::memory_order_relaxed) / 1e6;
+        stats.consumerWaitMs = consumerWaitNs.load(std::memory_order_relaxed) / 1e6;
+        for (int i = 0; i < QUEUE_DWELL_BUCKETS; ++i) {
+            stats.dwellHistogram[i] = dwellHistogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        resetTime.store(now());
+        peakDepth.store(0);
+        pushCount.store(0);
+        popCount.store(0);
+        producerWaitNs.store(0);
+        consumerWaitNs.store(0);
+        for (int i = 0; i < QUEUE_DWELL_BUCKETS; ++i) {
+            dwellHistogram[i].store(0);
+        }
+    }
+
+private:
+    std::atomic<Stamp> resetTime;
+    std::atomic<size_t> peakDepth;
+    std::atomic<size_t> pushCount;
+    std::atomic<size_t> popCount;
+    std::atomic<long long> producerWaitNs;
+    std::atomic<long long> consumerWaitNs;
+    std::atomic<size_t> dwellHistogram[QUEUE_DWELL_BUCKETS];
+
+    long long elapsedNs(Stamp since) const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now() - since).count();
+    }
+};
+
+#else
+
+// Compiled out: every hook is an empty inline function and no timestamps are taken
+class QueueInstrumentation {
+public:
+    struct Stamp {};
+    Stamp now() const { return Stamp(); }
+    void onPush(size_t, Stamp) {}
+    void onPop(Stamp, Stamp) {}
+    void fill(QueueStats&) const {}
+    void reset() {}
+};
+
+#endif
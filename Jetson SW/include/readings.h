@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/* Values each model reports per frame */
+#define READINGS_VALUE_COUNT    9
+/* Reported for values a model did not produce, same as a missing engine */
+#define READINGS_MISSING_VALUE  -100
+
+// One frame's model outputs, fixed layout so it moves through the queues without touching the heap
+// and is copied straight into the send buffer
+struct Readings {
+    uint64_t frameId;         // FramePacket::frameId of the frame the readings came from
+    int64_t captureTimeUs;    // FramePacket::captureTime, steady clock microseconds
+    std::array<float, READINGS_VALUE_COUNT> headPose;
+    std::array<float, READINGS_VALUE_COUNT> eyeGaze;
+
+    // Copies a model output into 'values', padding a short one with READINGS_MISSING_VALUE
+    static void fill(std::array<float, READINGS_VALUE_COUNT>& values, const std::vector<float>& output) {
+        size_t count = std::min(output.size(), values.size());
+        std::copy(output.begin(), output.begin() + count, values.begin());
+        std::fill(values.begin() + count, values.end(), static_cast<float>(READINGS_MISSING_VALUE));
+    }
+};
+
+static_assert(std::is_trivially_copyable<Readings>::value, "Readings must stay memcpy-able");
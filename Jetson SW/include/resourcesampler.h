@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Period of the background resource sampler */
+#define RESOURCE_SAMPLE_INTERVAL_MS     100
+/* Samples kept in the ring, a power of two: 1024 samples cover ~100 s at the default period */
+#define RESOURCE_SAMPLE_RING_SIZE       1024
+/* Inference windows kept per model for correlation with the samples */
+#define INFERENCE_WINDOW_LOG_SIZE       4096
+
+// One reading of the process and system state
+struct ResourceSample {
+    std::chrono::steady_clock::time_point time;
+    size_t rssBytes;          // Resident set size of the process
+    double cpuPercent;        // System wide CPU utilization since the previous sample
+    size_t minorFaults;       // Cumulative minor page faults of the process
+    size_t deviceUsedBytes;   // Device memory in use, 0 without a device probe
+};
+
+// Resources seen while a model was running, see ResourceSampler::summarize()
+struct ResourceSummary {
+    size_t samples = 0;                // Samples whose interval overlapped an inference
+    double averageCpuPercent = 0.0;
+    double averageRssBytes = 0.0;
+    size_t peakRssBytes = 0;
+    size_t pageFaults = 0;             // Minor faults during the overlapping intervals
+    size_t peakDeviceUsedBytes = 0;    // Peak device usage above the lowest one in the ring
+};
+
+typedef std::pair<std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point> InferenceWindow;
+
+// Start and end times of recent inferences of one model, oldest overwritten first. Not thread
+// safe, the owner records under the model's own lock
+class InferenceWindowLog {
+public:
+    InferenceWindowLog() : windows(INFERENCE_WINDOW_LOG_SIZE) {}
+
+    void add(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        windows[next] = InferenceWindow(start, end);
+        next = (next + 1) % windows.size();
+        count = std::min(count + 1, windows.size());
+    }
+
+    // Recorded windows, oldest first
+    std::vector<InferenceWindow> ordered() const {
+        std::vector<InferenceWindow> out;
+        out.reserve(count);
+        size_t first = (next + windows.size() - count) % windows.size();
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(windows[(first + i) % windows.size()]);
+        }
+        return out;
+    }
+
+    void clear() { count = 0; }
+
+private:
+    std::vector<InferenceWindow> windows;
+    size_t next = 0;
+    size_t count = 0;
+};
+
+// Reads RSS, CPU utilization, page faults and device memory on its own low-rate thread and keeps
+// the samples in a lock-free ring (one seqlock per slot). The inference path only records when it
+// ran; resources are matched to those windows when the metrics are logged
+class ResourceSampler {
+public:
+    // Returns the device memory in use in bytes, e.g. through cudaMemGetInfo
+    typedef std::function<size_t()> DeviceMemoryProbe;
+
+    explicit ResourceSampler(DeviceMemoryProbe deviceProbe = DeviceMemoryProbe());
+    ~ResourceSampler();
+
+    void start();
+    void stop();
+    void setInterval(int milliseconds);
+
+    // Copies of the samples in the ring, oldest first. Never blocks the sampler
+    std::vector<ResourceSample> snapshot() const;
+
+    // Samples whose interval (previous sample, sample] overlaps one of 'windows', oldest first
+    ResourceSummary summarize(const std::vector<InferenceWindow>& windows) const;
+
+    size_t getSampleCount() const { return written.load(std::memory_order_acquire); }
+
+    // Average time the sampler thread spends taking one sample, in ms
+    double getAverageSampleCost() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0}; // Odd while the sampler writes the slot
+        std::atomic<uint64_t> index{0};    // Sample number stored in the slot
+        std::atomic<int64_t> time{0};      // steady_clock ticks
+        std::atomic<uint64_t> rssBytes{0};
+        std::atomic<double> cpuPercent{0.0};
+        std::atomic<uint64_t> minorFaults{0};
+        std::atomic<uint64_t> deviceUsedBytes{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> written{0};
+    std::atomic<int> intervalMs{RESOURCE_SAMPLE_INTERVAL_MS};
+    std::atomic<double> totalSampleCost{0.0};
+    DeviceMemoryProbe deviceProbe;
+
+    std::mutex threadMtx; // Guards start() and stop()
+    std::thread samplerThread;
+    std::mutex waitMtx;
+    std::condition_variable wakeCv; // Ends the wait between samples on stop()
+    bool running = false;           // Guarded by waitMtx
+
+    long previousIdle = 0;
+    long previousTotal = 0;
+
+    void samplerLoop();
+    void takeSample();
+
+    ResourceSampler(const ResourceSampler&) = delete;
+    ResourceSampler& operator=(const ResourceSampler&) = delete;
+};
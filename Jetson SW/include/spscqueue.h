@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+
+// Fixed-capacity ring buffer for links with exactly one producer thread and one consumer thread.
+// push and tryPop never take a lock, head and tail live on separate cache lines so the
+// two threads do not invalidate each other's line on every operation.
+template<typename T>
+class SPSCQueue {
+public:
+    // Capacity is rounded up to the next power of two
+    explicit SPSCQueue(size_t requestedCapacity)
+        : head(0), cachedTail(0), tail(0), cachedHead(0), flushTo(NoFlush), sleepers(0), closed(false) {
+        size_t capacity = 1;
+        while (capacity < requestedCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        slots.resize(capacity);
+    }
+
+    // Producer only. Returns false if the ring is full or closed
+    bool push(const T& item) {
+        return pushValue(item);
+    }
+
+    // Producer only. The item is only moved from if the push succeeds
+    bool push(T&& item) {
+        return pushValue(std::move(item));
+    }
+
+    // Consumer only. Returns false if the ring is empty
+    bool tryPop(T& item) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        currentHead = applyFlush(currentHead);
+        if (currentHead == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (currentHead == cachedTail) {
+                return false;
+            }
+        }
+        T& slot = slots[currentHead & mask];
+        item = std::move(slot);
+        slot = T(); // Release whatever the slot references (frame buffers) right away
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Spins briefly, then parks until the producer pushes.
+    // Returns false once the ring is closed and empty
+    bool waitAndPop(T& item) {
+        while (!closed.load(std::memory_order_acquire)) {
+            if (waitPopFor(item, std::chrono::milliseconds(ParkTimeoutMs))) {
+                return true;
+            }
+        }
+        return tryPop(item);
+    }
+
+    // Consumer only. Returns false if nothing arrived within the timeout or the ring was closed
+    template<typename Rep, typename Period>
+    bool waitPopFor(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+        for (int spin = 0; spin < SpinCount; ++spin) {
+            if (tryPop(item)) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(parkMtx);
+        sleepers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = tryPop(item);
+        while (!popped && !closed.load(std::memory_order_acquire) &&
+               parkVar.wait_until(lock, deadline) == std::cv_status::no_timeout) {
+            popped = tryPop(item);
+        }
+        sleepers.fetch_sub(1);
+        return popped || tryPop(item);
+    }
+
+    // Consumer only. Moves up to maxItems queued items to the back of 'items', returns how many
+    size_t drain(std::vector<T>& items, size_t maxItems) {
+        size_t count = 0;
+        T item;
+        while (count < maxItems && tryPop(item)) {
+            items.push_back(std::move(item));
+            ++count;
+        }
+        return count;
+    }
+
+    // Safe from any thread: rejects further pushes and wakes a parked consumer
+    void close() {
+        closed.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(parkMtx);
+        parkVar.notify_all();
+    }
+
+    void reopen() {
+        closed.store(false, std::memory_order_release);
+    }
+
+    bool isClosed() const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+    // Safe from any thread. Approximate while the producer or consumer is running
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t size() const {
+        const size_t currentHead = head.load(std::memory_order_acquire);
+        const size_t currentTail = tail.load(std::memory_order_acquire);
+        return currentTail - currentHead;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Safe from any thread: asks the consumer to discard everything pushed so far on its next pop
+    void clear() {
+        flushTo.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    static const size_t CacheLineSize = 64;
+    static const size_t NoFlush = static_cast<size_t>(-1);
+    enum { SpinCount = 64, ParkTimeoutMs = 100 };
+
+    // Consumer side
+    std::atomic<size_t> head;
+    size_t cachedTail; // Consumer's last view of tail
+    char consumerPad[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    // Producer side
+    std::atomic<size_t> tail;
+    size_t cachedHead; // Producer's last view of head
+    char producerPad[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    std::atomic<size_t> flushTo; // Pending clear() request, NoFlush when none
+    std::atomic<int> sleepers;   // Consumers parked in waitPopFor
+    std::atomic<bool> closed;
+    char sharedPad[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(std::atomic<int>) - sizeof(std::atomic<bool>)];
+
+    size_t mask;
+    std::vector<T> slots;
+    std::mutex parkMtx;
+    std::condition_variable parkVar;
+
+    template<typename U>
+    bool pushValue(U&& item) {
+        if (closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (currentTail - cachedHead > mask) {
+                return false;
+            }
+        }
+        slots[currentTail & mask] = std::forward<U>(item);
+        tail.store(currentTail + 1, std::memory_order_release);
+        wakeConsumer();
+        return true;
+    }
+
+    // Consumer only. Drops the items covered by a pending clear() request
+    size_t applyFlush(size_t currentHead) {
+        size_t target = flushTo.load(std::memory_order_acquire);
+        if (target == NoFlush) {
+            return currentHead;
+        }
+        flushTo.compare_exchange_strong(target, NoFlush);
+        while (static_cast<std::ptrdiff_t>(target - currentHead) > 0) {
+            slots[currentHead & mask] = T();
+            ++currentHead;
+        }
+        cachedTail = tail.load(std::memory_order_acquire);
+        head.store(currentHead, std::memory_order_release);
+        return currentHead;
+    }
+
+    // Producer only. Only touches the mutex when the consumer is actually parked
+    void wakeConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(parkMtx);
+            parkVar.notify_one();
+        }
+    }
+};
@@ -3,6 +3,27 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <limits>
+#include <utility>
+#include "spscqueue.h"
+#include "queuestats.h"
+
+/* How long component loops wait on a queue before re-checking their running flag */
+#define QUEUE_WAIT_TIMEOUT_MS   100
+
+// What a bounded queue does when an item is pushed while it is full
+enum class OverflowPolicy {
+    Block,       // Producer waits until the consumer makes room
+    DropOldest,  // Discard the item at the head of the queue
+    DropNewest,  // Discard the item being pushed
+    KeepLatest   // Discard everything queued and keep only the pushed item
+};
 
 template<typename T>
 class ThreadSafeQueue {
@@ -10,51 +31,362 @@ public:
     ThreadSafeQueue() = default;
     ~ThreadSafeQueue() = default;
 
-    // Add an item to the queue
-    void push(const T& item) {
+    // Limit the queue to 'capacity' items (0 means unbounded) and choose what happens when it is full.
+    // A lock-free queue keeps its ring capacity and only takes Block or DropNewest, anything else
+    // is rejected and returns false
+    bool setCapacity(size_t capacity, OverflowPolicy policy) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (ring) {
+            if (capacity != this->capacity || !ringSupports(policy)) {
+                return false;
+            }
+            lockFreePolicy.store(policy);
+            this->policy = policy;
+            return true;
+        }
+        this->capacity = capacity;
+        this->policy = policy;
+        while (this->capacity > 0 && dataQueue.size() > this->capacity) {
+            dataQueue.pop();
+            droppedCount++;
+        }
+        lock.unlock();
+        notFullVar.notify_all();
+        return true;
+    }
+
+    // Turn the queue into a single-slot mailbox: every push overwrites the unread item, so the
+    // consumer always gets the freshest one. Overwritten items are counted as drops.
+    // Returns false on a lock-free queue, the ring cannot discard from the producer side
+    bool makeMailbox() {
+        return setCapacity(1, OverflowPolicy::KeepLatest);
+    }
+
+    bool isMailbox() const {
+        std::unique_lock<std::mutex> lock(mtx);
+        return !ring && policy == OverflowPolicy::KeepLatest;
+    }
+
+    // Switch the queue to a lock-free ring of the given capacity. Only valid for links with exactly
+    // one producer and one consumer thread, and must be called before either thread starts.
+    // A full ring blocks the producer under OverflowPolicy::Block and drops the pushed item under
+    // DropNewest. Returns false, leaving the queue as it is, when it is already lock-free or its
+    // policy is DropOldest or KeepLatest, which only the consumer side of a ring could enforce
+    bool enableLockFree(size_t capacity) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (ring || !ringSupports(policy)) {
+            return false;
+        }
+        ring.reset(new SPSCQueue<Slot>(capacity));
+        this->capacity = ring->capacity();
+        lockFreePolicy.store(policy);
+        return true;
+    }
+
+    bool isLockFree() const {
+        return ring != nullptr;
+    }
+
+    // Add an item to the queue. Returns false if the item was dropped by the overflow policy
+    // or the queue is closed
+    bool push(const T& item) {
+        return emplace(item);
+    }
+
+    // Move an item into the queue, avoids copying heap-backed items (vectors, strings)
+    bool push(T&& item) {
+        return emplace(std::move(item));
+    }
+
+    // Construct an item in place at the back of the queue
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        const QueueInstrumentation::Stamp waitStart = stats.now();
+        if (ring) {
+            Slot slot(std::piecewise_construct, std::forward<Args>(args)...);
+            stamp(slot);
+            if (!pushLockFree(std::move(slot))) {
+                return false;
+            }
+            stats.onPush(ring->size(), waitStart);
+            return true;
+        }
         std::unique_lock<std::mutex> lock(mtx);
-        dataQueue.push(item);
+        if (closed || !makeRoom(lock)) {
+            return false;
+        }
+        dataQueue.emplace(std::piecewise_construct, std::forward<Args>(args)...);
+        stamp(dataQueue.back());
+        stats.onPush(dataQueue.size(), waitStart);
         lock.unlock();
         condVar.notify_one();
+        return true;
     }
 
     // Try to pop an item from the queue. Returns false if the queue is empty
     bool tryPop(T& item) {
+        const QueueInstrumentation::Stamp waitStart = stats.now();
+        if (ring) {
+            Slot slot;
+            return ring->tryPop(slot) && takeSlot(slot, item, waitStart);
+        }
         std::unique_lock<std::mutex> lock(mtx);
-        if (dataQueue.empty()) {
-            return false;
+        return popLocked(lock, item, waitStart);
+    }
+
+    // Wait and pop an item from the queue. Returns false if the queue was closed while empty
+    bool waitAndPop(T& item) {
+        const QueueInstrumentation::Stamp waitStart = stats.now();
+        if (ring) {
+            Slot slot;
+            return ring->waitAndPop(slot) && takeSlot(slot, item, waitStart);
         }
-        item = dataQueue.front();
-        dataQueue.pop();
-        return true;
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [this]{ return !dataQueue.empty() || closed; });
+        return popLocked(lock, item, waitStart);
     }
 
-    // Wait and pop an item from the queue
-    void waitAndPop(T& item) {
+    // Wait up to 'timeout' for an item. Returns false on timeout or if the queue was closed while empty
+    template<typename Rep, typename Period>
+    bool waitPopFor(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+        const QueueInstrumentation::Stamp waitStart = stats.now();
+        if (ring) {
+            Slot slot;
+            return ring->waitPopFor(slot, timeout) && takeSlot(slot, item, waitStart);
+        }
         std::unique_lock<std::mutex> lock(mtx);
-        condVar.wait(lock, [this]{ return !dataQueue.empty(); });
-        item = dataQueue.front();
-        dataQueue.pop();
+        condVar.wait_for(lock, timeout, [this]{ return !dataQueue.empty() || closed; });
+        return popLocked(lock, item, waitStart);
+    }
+
+    // Move up to maxItems queued items to the back of 'items' under a single lock acquisition.
+    // Returns the number of items moved
+    size_t drain(std::vector<T>& items, size_t maxItems = std::numeric_limits<size_t>::max()) {
+        const QueueInstrumentation::Stamp waitStart = stats.now();
+        size_t count = 0;
+        if (ring) {
+            Slot slot;
+            while (count < maxItems && ring->tryPop(slot)) {
+                stats.onPop(enqueuedAt(slot), waitStart);
+                items.push_back(std::move(slot.value));
+                ++count;
+            }
+            return count;
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        while (count < maxItems && !dataQueue.empty()) {
+            stats.onPop(enqueuedAt(dataQueue.front()), waitStart);
+            items.push_back(std::move(dataQueue.front().value));
+            dataQueue.pop();
+            ++count;
+        }
+        lock.unlock();
+        if (count > 0) {
+            notFullVar.notify_all();
+        }
+        return count;
+    }
+
+    // Reject further pushes and wake every waiting producer and consumer.
+    // Items already queued can still be popped
+    void close() {
+        if (ring) {
+            ring->close();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        closed = true;
+        lock.unlock();
+        condVar.notify_all();
+        notFullVar.notify_all();
+    }
+
+    // Accept pushes again after close()
+    void reopen() {
+        if (ring) {
+            ring->reopen();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        closed = false;
+    }
+
+    bool isClosed() const {
+        if (ring) {
+            return ring->isClosed();
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        return closed;
     }
 
     // Check if the queue is empty
     bool empty() const {
+        if (ring) {
+            return ring->empty();
+        }
         std::unique_lock<std::mutex> lock(mtx);
         return dataQueue.empty();
     }
 
+    // Number of items currently queued
+    size_t size() const {
+        if (ring) {
+            return ring->size();
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        return dataQueue.size();
+    }
+
+    // Number of items discarded by the overflow policy since construction
+    size_t getDroppedCount() const {
+        std::unique_lock<std::mutex> lock(mtx);
+        return droppedCount + lockFreeDropped.load(std::memory_order_relaxed);
+    }
+
+    size_t getCapacity() const {
+        std::unique_lock<std::mutex> lock(mtx);
+        return capacity;
+    }
+
+    OverflowPolicy getPolicy() const {
+        std::unique_lock<std::mutex> lock(mtx);
+        return policy;
+    }
+
+    // Depth, drop count and, when built with QUEUE_INSTRUMENTATION, rates, wait times and the
+    // dwell-time histogram. Safe to call while the pipeline is running
+    QueueStats getStats() const {
+        QueueStats snapshot;
+        snapshot.depth = size();
+        snapshot.droppedCount = getDroppedCount();
+        snapshot.mailbox = isMailbox();
+        stats.fill(snapshot);
+        return snapshot;
+    }
+
+    // Restart peak depth, rates, wait times and the histogram
+    void resetStats() {
+        stats.reset();
+    }
+
     // Clear all items from the queue
     void clear() {
+        if (ring) {
+            ring->clear();
+            return;
+        }
         std::unique_lock<std::mutex> lock(mtx);
-        std::queue<T> emptyQueue;
+        std::queue<Slot> emptyQueue;
         std::swap(dataQueue, emptyQueue);
         // Optionally, notify all waiting threads that the state has changed
         condVar.notify_all();
+        notFullVar.notify_all();
     }
 
 private:
+    // Queued item plus, when instrumented, the time it entered the queue
+    struct Slot {
+        T value;
+#ifdef QUEUE_INSTRUMENTATION
+        QueueInstrumentation::Stamp enqueued;
+#endif
+        Slot() = default;
+        template<typename... Args>
+        Slot(std::piecewise_construct_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+    };
+
     mutable std::mutex mtx;
-    std::queue<T> dataQueue;
-    std::condition_variable condVar;
-};
+    std::queue<Slot> dataQueue;
+    std::condition_variable condVar;     // Signalled when an item is pushed
+    std::condition_variable notFullVar;  // Signalled when an item leaves the queue
+
+    size_t capacity = 0; // 0 means unbounded
+    OverflowPolicy policy = OverflowPolicy::Block;
+    size_t droppedCount = 0;
+    bool closed = false;
 
+    // Lock-free mode, the ring is only set before the producer and consumer threads start
+    std::unique_ptr<SPSCQueue<Slot>> ring;
+    std::atomic<OverflowPolicy> lockFreePolicy{OverflowPolicy::Block};
+    std::atomic<size_t> lockFreeDropped{0};
+
+    QueueInstrumentation stats;
+
+    void stamp(Slot& slot) {
+#ifdef QUEUE_INSTRUMENTATION
+        slot.enqueued = stats.now();
+#endif
+    }
+
+    QueueInstrumentation::Stamp enqueuedAt(const Slot& slot) const {
+#ifdef QUEUE_INSTRUMENTATION
+        return slot.enqueued;
+#else
+        return QueueInstrumentation::Stamp();
+#endif
+    }
+
+    bool takeSlot(Slot& slot, T& item, QueueInstrumentation::Stamp waitStart) {
+        stats.onPop(enqueuedAt(slot), waitStart);
+        item = std::move(slot.value);
+        return true;
+    }
+
+    static bool ringSupports(OverflowPolicy policy) {
+        return policy == OverflowPolicy::Block || policy == OverflowPolicy::DropNewest;
+    }
+
+    bool pushLockFree(Slot&& item) {
+        while (!ring->push(std::move(item))) {
+            if (ring->isClosed()) {
+                return false;
+            }
+            if (lockFreePolicy.load(std::memory_order_relaxed) == OverflowPolicy::DropNewest) {
+                lockFreeDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // Pop the head item with the lock held, then release the lock and wake a blocked producer
+    bool popLocked(std::unique_lock<std::mutex>& lock, T& item, QueueInstrumentation::Stamp waitStart) {
+        if (dataQueue.empty()) {
+            return false;
+        }
+        takeSlot(dataQueue.front(), item, waitStart);
+        dataQueue.pop();
+        lock.unlock();
+        notFullVar.notify_one();
+        return true;
+    }
+
+    // Apply the overflow policy before a push. Returns false if the new item must be dropped
+    bool makeRoom(std::unique_lock<std::mutex>& lock) {
+        if (policy == OverflowPolicy::KeepLatest) {
+            droppedCount += dataQueue.size();
+            std::queue<Slot> emptyQueue;
+            std::swap(dataQueue, emptyQueue);
+            return true;
+        }
+        if (capacity == 0 || dataQueue.size() < capacity) {
+            return true;
+        }
+        switch (policy) {
+            case OverflowPolicy::Block:
+                notFullVar.wait(lock, [this]{ return capacity == 0 || dataQueue.size() < capacity || closed; });
+                return !closed;
+            case OverflowPolicy::DropOldest:
+                while (dataQueue.size() >= capacity) {
+                    dataQueue.pop();
+                    droppedCount++;
+                }
+                return true;
+            case OverflowPolicy::DropNewest:
+            default:
+                droppedCount++;
+                return false;
+        }
+    }
+};
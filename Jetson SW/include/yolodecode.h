@@ -0,0 +1,20 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+/* Overlap above which the weaker of two face boxes is suppressed */
+#define YOLO_NMS_THRESHOLD      0.4f
+
+// A face box left after NMS, in frame coordinates
+struct FaceCandidate {
+    cv::Rect box;
+    float confidence;
+};
+
+// Decode YOLO output layers (rows of x, y, w, h, objectness, class scores, relative to 'area' of the
+// frame) into 'faces', strongest first. Rows at or below 'threshold' objectness are dropped by a
+// scan of that column before any box is built, the survivors go through NMS. Returns the number
+// of boxes that passed the scan, before NMS
+size_t decodeFaces(const std::vector<cv::Mat>& outs, const cv::Rect& area, float threshold,
+                   std::vector<FaceCandidate>& faces);
@@ -59,7 +59,7 @@ void DrowsinessComponent::drowsinessDetectionLoop() {
     this->lastTime = std::chrono::high_resolution_clock::now(); // Initialize the last time
 
     while (running) {
-        if (inputQueue.tryPop(frame)) {
+        if (inputQueue.waitPopFor(frame, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
 
 
 
@@ -10,15 +10,15 @@ namespace pt = boost::posix_time;
 namespace gr = boost::gregorian;
 
 TRTEngineSingleton* TRTEngineSingleton::instance = nullptr;
+std::mutex TRTEngineSingleton::mtx;
 
 // Constructor
-AIComponent::AIComponent(ThreadSafeQueue<cv::Mat>& inputQueue,
-                                     ThreadSafeQueue<cv::Rect>& faceRectQueue,
-                                     ThreadSafeQueue<std::vector<std::vector<float>>>& outputQueue,
-                                     ThreadSafeQueue<cv::Mat>& framesQueue,
+AIComponent::AIComponent(ThreadSafeQueue<FramePacket>& inputQueue,
+                                     ThreadSafeQueue<Readings>& outputQueue,
+                                     ThreadSafeQueue<FramePacket>& framesQueue,
                                      ThreadSafeQueue<std::string>& commandsQueue,
                                      ThreadSafeQueue<std::string>& faultsQueue)
-    : inputQueue(inputQueue), faceRectQueue(faceRectQueue), outputQueue(outputQueue),
+    : inputQueue(inputQueue), outputQueue(outputQueue),
       framesQueue(framesQueue), commandsQueue(commandsQueue), faultsQueue(faultsQueue), running(false){}
 
 // Destructor
@@ -35,6 +35,12 @@ void AIComponent::startAIDetection() {
         return;
     }
     running = true;
+    {
+        std::lock_guard<std::mutex> lock(eyeGazeMtx);
+        eyeGazeStop = false;
+    }
+    eyeGazeThread = std::thread(&AIComponent::eyeGazeWorkerLoop, this);
+    TRTEngineSingleton::getInstance()->getResourceSampler().start();
     AIDetectionThread = std::thread(&AIComponent::AIDetectionLoop, this);
 }
 
@@ -44,44 +50,86 @@ void AIComponent::stopAIDetection() {
     if (AIDetectionThread.joinable()) {
         AIDetectionThread.join();
     }
+    {
+        std::lock_guard<std::mutex> lock(eyeGazeMtx);
+        eyeGazeStop = true;
+    }
+    eyeGazeCv.notify_all();
+    if (eyeGazeThread.joinable()) {
+        eyeGazeThread.join();
+    }
+    TRTEngineSingleton::getInstance()->getResourceSampler().stop();
+}
+
+// Eye gaze worker, runs one submitted input at a time
+void AIComponent::eyeGazeWorkerLoop() {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    std::unique_lock<std::mutex> lock(eyeGazeMtx);
+    while (true) {
+        eyeGazeCv.wait(lock, [this] { return eyeGazeJob || eyeGazeStop; });
+        if (eyeGazeStop) {
+            break;
+        }
+        std::shared_ptr<const PreprocessedFace> input = std::move(eyeGazeJob);
+        eyeGazeJob.reset();
+        lock.unlock();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<float> result = trt->inferEyeGaze(input->eyeGaze.data());
+        auto end = std::chrono::high_resolution_clock::now();
+
+        lock.lock();
+        eyeGazeResult = std::move(result);
+        eyeGazeJobTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        eyeGazeDone = true;
+        eyeGazeCv.notify_all();
+    }
 }
 
 // Detection loop
 void AIComponent::AIDetectionLoop() {
-    cv::Mat frame;
-    bool isFirstFrame = true; 
+    FramePacket packet;
 
+    // The input link is a mailbox, so the packet popped here is always the newest one
     while (running) {
-        if (inputQueue.tryPop(frame)) {
-            cv::Mat croppedFace;
-            cv::Rect faceRect = detectFaceRectangle(frame);
-            if (faceRect.x >= 0 && faceRect.y >= 0 &&
-                faceRect.width > 0 && faceRect.height > 0 &&
-                faceRect.x + faceRect.width <= frame.cols &&
-                faceRect.y + faceRect.height <= frame.rows) {
-                croppedFace = frame(faceRect);
-            } else {
-                croppedFace = frame; 
-            }
-            
-            auto readings = detectAI(croppedFace);
-            framesQueue.push(frame);
-            outputQueue.push(readings);
-
-            if (isFirstFrame) {
-                inputQueue.clear(); 
-                isFirstFrame = false;
+        if (inputQueue.waitPopFor(packet, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
+            // Face detection looked and found nothing: still show the frame, skip inference
+            if (packet.faceSearched && !packet.hasRoi) {
+                framesQueue.push(std::move(packet));
+                continue;
             }
+
+            // Without face detection the whole frame is used, as before
+            cv::Mat croppedFace = packet.hasRoi ? packet.frame(packet.roi) : packet.frame;
+
+            packet.aiStart = FramePacket::Clock::now();
+            auto readings = detectAI(packet, croppedFace);
+            packet.aiEnd = FramePacket::Clock::now();
+            framesQueue.push(std::move(packet));
+            outputQueue.push(std::move(readings));
         }
     }
 }
 
 // Detect head pose and eye gaze
-std::vector<std::vector<float>> AIComponent::detectAI(cv::Mat& croppedFace) {
+Readings AIComponent::detectAI(const FramePacket& packet, const cv::Mat& croppedFace) {
     TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
 
+    // Both model inputs come from one cache entry, computed here on a miss
+    std::shared_ptr<const PreprocessedFace> input = preprocessCache.lookup(packet.frameId, packet.roi, croppedFace);
+
+    // Hand the eye gaze input to the worker first
+    auto startFrame = std::chrono::high_resolution_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(eyeGazeMtx);
+        eyeGazeJob = input;
+        eyeGazeDone = false;
+    }
+    eyeGazeCv.notify_all();
+
+    // Head pose runs here meanwhile
     auto startHeadPose = std::chrono::high_resolution_clock::now();
-    auto headPoseResult = trt->inferHeadPose(croppedFace);
+    auto headPoseResult = trt->inferHeadPose(input->headPose.data());
     auto endHeadPose = std::chrono::high_resolution_clock::now();
     double headPoseTime = std::chrono::duration_cast<std::chrono::milliseconds>(endHeadPose - startHeadPose).count();
     if (headPoseTime > 45) {
@@ -91,17 +139,28 @@ std::vector<std::vector<float>> AIComponent::detectAI(cv::Mat& croppedFace) {
         totalHeadPoseTime += headPoseTime;
         headPoseCount++;
     }
-    
-
-    // Crop the upper 55% of the image
-    int newHeight = static_cast<int>(croppedFace.rows * 0.55);
-    cv::Rect roi(0, 0, croppedFace.cols, newHeight);
-    cv::Mat upperCroppedFace = croppedFace(roi);
-   
-    auto startEyeGaze = std::chrono::high_resolution_clock::now();
-    auto eyeGazeResult = trt->inferEyeGaze(upperCroppedFace);
-    auto endEyeGaze = std::chrono::high_resolution_clock::now();
-    double eyeGazeTime = std::chrono::duration_cast<std::chrono::milliseconds>(endEyeGaze - startEyeGaze).count();
+
+    // Wait for the eye gaze worker, the frame costs the longer of the two models
+    std::vector<float> eyeGazeOutput;
+    double eyeGazeTime;
+    {
+        std::unique_lock<std::mutex> lock(eyeGazeMtx);
+        eyeGazeCv.wait(lock, [this] { return eyeGazeDone || eyeGazeStop; });
+        if (!eyeGazeDone) {
+            // Stopped while waiting, same defaults as a missing engine
+            eyeGazeOutput.assign(9, -100);
+        } else {
+            eyeGazeOutput = std::move(eyeGazeResult);
+        }
+        eyeGazeTime = eyeGazeJobTime;
+    }
+    auto endFrame = std::chrono::high_resolution_clock::now();
+    double frameTime = std::chrono::duration_cast<std::chrono::milliseconds>(endFrame - startFrame).count();
+    maxFrameAITime = std::max(maxFrameAITime, frameTime);
+    totalFrameAITime += frameTime;
+    totalModelSumTime += headPoseTime + eyeGazeTime;
+    frameAICount++;
+
     if (eyeGazeTime > 30) {
         eyeGazeTimes.push_back(eyeGazeTime);
         maxEyeGazeTime = std::max(maxEyeGazeTime, eyeGazeTime);
@@ -110,18 +169,13 @@ std::vector<std::vector<float>> AIComponent::detectAI(cv::Mat& croppedFace) {
         eyeGazeCount++;
     }
 
-    std::vector<std::vector<float>> out{headPoseResult, eyeGazeResult};
-    return out;
-}
-
-// Detect face rectangle
-cv::Rect AIComponent::detectFaceRectangle(const cv::Mat& frame) {
-    cv::Rect faceRect;
-    if (!faceRectQueue.tryPop(faceRect)) {
-        std::cerr << "No face rectangle found in the queue." << std::endl;
-        return cv::Rect(); // Return an empty rectangle
-    }
-    return faceRect;
+    Readings readings;
+    readings.frameId = packet.frameId;
+    readings.captureTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        packet.captureTime.time_since_epoch()).count();
+    Readings::fill(readings.headPose, headPoseResult);
+    Readings::fill(readings.eyeGaze, eyeGazeOutput);
+    return readings;
 }
 
 // Update performance metrics
@@ -149,20 +203,40 @@ void AIComponent::displayPerformanceMetrics(cv::Mat& frame) {
 
 }
 
-// Update the engine for head pose detection
+// Update the engine for head pose detection, loaded in the background while frames keep flowing
 void AIComponent::updateHeadPoseEngine(const std::string& headPoseEnginePath) {
     TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
     trt->setEngine1(headPoseEnginePath);
-    std::cout << "Head pose engine updated successfully." << std::endl;
-    commandsQueue.push("Clear Queue");
 }
 
-// Update the engine for eye gaze detection
+// Update the engine for eye gaze detection, loaded in the background while frames keep flowing
 void AIComponent::updateEyeGazeEngine(const std::string& eyeGazeEnginePath) {
     TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
     trt->setEngine2(eyeGazeEnginePath);
-    std::cout << "Eye gaze engine updated successfully." << std::endl;
-    commandsQueue.push("Clear Queue");
+}
+
+// Switch the inference backend of both models, reloaded in the background
+void AIComponent::updateInferenceBackend(InferenceBackendType type) {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    trt->setBackend(type);
+}
+
+// Preload engines into the model cache
+void AIComponent::preloadModels(const std::vector<std::string>& headPosePaths, const std::vector<std::string>& eyeGazePaths) {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    trt->preloadModels(headPosePaths, eyeGazePaths);
+}
+
+// Set the model cache budget
+void AIComponent::setModelCacheBudget(size_t budgetMB) {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    trt->setModelCacheBudget(budgetMB);
+}
+
+// Set micro-batching of the inference requests
+void AIComponent::setBatching(size_t maxBatch, int deadlineUs) {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    trt->setBatching(maxBatch, deadlineUs);
 }
 
 // Log performance metrics
@@ -188,32 +262,61 @@ void AIComponent::logPerformanceMetrics() {
     if (minEyeGazeTime == std::numeric_limits<double>::max()) { minEyeGazeTime = 0; }
 
     logFile << "<<------------------------------------------------------------------->>\n";
+    TRTEngineSingleton* engine = TRTEngineSingleton::getInstance();
     logFile << "Head Pose Engine Metrics:\n";
+    logFile << "Backend: " << engine->getHeadPoseBackendName() << "\n";
     logFile << "Max Time: " << maxHeadPoseTime << " ms\n";
     logFile << "Min Time: " << minHeadPoseTime << " ms\n";
     logFile << "Average Time: " << averageHeadPoseTime << " ms\n\n";
 
     logFile << "Eye Gaze Engine Metrics:\n";
+    logFile << "Backend: " << engine->getEyeGazeBackendName() << "\n";
     logFile << "Max Time: " << maxEyeGazeTime << " ms\n";
     logFile << "Min Time: " << minEyeGazeTime << " ms\n";
     logFile << "Average Time: " << averageEyeGazeTime << " ms\n\n";
 
-    TRTEngineSingleton* engine = TRTEngineSingleton::getInstance();
+    // Resources come from the background sampler, matched to the intervals in which each model ran
+    ResourceSummary headPoseResources = engine->getHeadPoseResourceSummary();
+    ResourceSummary eyeGazeResources = engine->getEyeGazeResourceSummary();
     logFile << "Peak GPU Memory Usage for Head Pose: "
-            << static_cast<double>(engine->getPeakHeadPoseGpuMemoryUsage()) / (1024 * 1024) << " MB\n";
+            << static_cast<double>(headPoseResources.peakDeviceUsedBytes) / (1024 * 1024) << " MB\n";
     logFile << "Peak GPU Memory Usage for Eye Gaze: "
-            << static_cast<double>(engine->getPeakEyeGazeGpuMemoryUsage()) / (1024 * 1024) << " MB\n";
+            << static_cast<double>(eyeGazeResources.peakDeviceUsedBytes) / (1024 * 1024) << " MB\n";
 
     logFile << "Average CPU Memory Usage for Head Pose: "
-            << static_cast<double>(engine->gettotalCpuMemoryUsageHeadPose()) / engine->getheadPoseInferenceCount() / (1024 * 1024) << " MB\n";
+            << headPoseResources.averageRssBytes / (1024 * 1024) << " MB (peak "
+            << static_cast<double>(headPoseResources.peakRssBytes) / (1024 * 1024) << " MB)\n";
     logFile << "Average CPU Memory Usage for Eye Gaze: "
-            << static_cast<double>(engine->gettotalCpuMemoryUsageEyeGaze()) / engine->geteyeGazeInferenceCount() / (1024 * 1024) << " MB\n";
-
-    logFile << "Average CPU Usage for Head Pose: "
-            << static_cast<double>(engine->getheadPoseCpuUsage()) / engine->getheadPoseInferenceCount() << " %\n";
-
-    logFile << "Average CPU Usage for Eye Gaze: "
-            << static_cast<double>(engine->geteyeGazeCpuUsage()) / engine->geteyeGazeInferenceCount() << " %\n";
+            << eyeGazeResources.averageRssBytes / (1024 * 1024) << " MB (peak "
+            << static_cast<double>(eyeGazeResources.peakRssBytes) / (1024 * 1024) << " MB)\n";
+
+    logFile << "Average CPU Usage for Head Pose: " << headPoseResources.averageCpuPercent << " %\n";
+
+    logFile << "Average CPU Usage for Eye Gaze: " << eyeGazeResources.averageCpuPercent << " %\n";
+
+    logFile << "Page Faults during Head Pose: " << headPoseResources.pageFaults << "\n";
+    logFile << "Page Faults during Eye Gaze: " << eyeGazeResources.pageFaults << "\n";
+    logFile << "Resource Samples: " << headPoseResources.samples << " head pose, " << eyeGazeResources.samples
+            << " eye gaze, " << engine->getResourceSampler().getAverageSampleCost() << " ms per sample off the inference path\n";
+
+    logFile << "Concurrent AI Time per Frame: max " << maxFrameAITime << " ms, average "
+            << (frameAICount > 0 ? totalFrameAITime / frameAICount : 0) << " ms\n";
+    logFile << "Sum of Model Times per Frame: average "
+            << (frameAICount > 0 ? totalModelSumTime / frameAICount : 0) << " ms\n\n";
+
+    logFile << "Engine Swaps: " << engine->getSwapCount() << "\n";
+    logFile << "Average Swap Latency: " << engine->getAverageSwapLatency() << " ms\n";
+    logFile << "Max Swap Latency: " << engine->getMaxSwapLatency() << " ms\n";
+    logFile << "Engine Loads: " << engine->getLoadCount() << "\n";
+    logFile << "Average Load Time: " << engine->getAverageLoadTime() << " ms\n";
+    logFile << "Max Load Time: " << engine->getMaxLoadTime() << " ms\n\n";
+    engine->resetSwapMetrics();
+    engine->logModelCacheMetrics(logFile);
+    logFile << "\n";
+
+    logFile << "Preprocessing Cache Hits: " << preprocessCache.getHits() << " (AI detection is the only consumer, hits come from later stages)\n";
+    logFile << "Preprocessing Cache Misses: " << preprocessCache.getMisses() << "\n";
+    preprocessCache.resetMetrics();
     logFile << "<<------------------------------------------------------------------->>\n";
 
     resetPerformanceMetrics();
@@ -231,5 +334,9 @@ void AIComponent::resetPerformanceMetrics() {
 	minEyeGazeTime = std::numeric_limits<double>::max();
 	maxHeadPoseTime = 0.0;
 	maxEyeGazeTime = 0.0;
+	maxFrameAITime = 0.0;
+	totalFrameAITime = 0.0;
+	totalModelSumTime = 0.0;
+	frameAICount = 0;
 }
 
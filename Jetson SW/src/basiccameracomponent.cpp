@@ -1,7 +1,7 @@
 #include "basiccameracomponent.h"
 
 // Constructor
-BasicCameraComponent::BasicCameraComponent(ThreadSafeQueue<cv::Mat>& outputQueue,
+BasicCameraComponent::BasicCameraComponent(ThreadSafeQueue<FramePacket>& outputQueue,
                                            ThreadSafeQueue<std::string>& commandsQueue,
                                            ThreadSafeQueue<std::string>& faultsQueue)
     : outputQueue(outputQueue), commandsQueue(commandsQueue), faultsQueue(faultsQueue), running(false) {}
@@ -17,6 +17,7 @@ bool BasicCameraComponent::initialize(const std::string& source) {
         std::cerr << "Failed to open camera or video file: " << source << std::endl;
         return false;
     }
+    reserveFramePool();
     return true;
 }
 
@@ -45,13 +46,20 @@ void BasicCameraComponent::captureLoop() {
         int delay = 1000 / fps;
         auto start = std::chrono::steady_clock::now();
         
+        // Capture straight into a pooled buffer instead of a fresh heap allocation
         cv::Mat frame;
+        frame.allocator = FramePool::getInstance();
         if (!cap.read(frame)) {
             std::cerr << "Failed to capture frame." << std::endl;
             running = false;
             break;
         }
         
+        // The source did not report its frame size up front, size the pool from the real frame
+        if (frame.total() * frame.elemSize() > FramePool::getInstance()->getBlockSize()) {
+            FramePool::getInstance()->reserve(frame.total() * frame.elemSize(), FRAME_POOL_SIZE);
+        }
+
 
         if (!frame.empty()) {
 
@@ -61,7 +69,11 @@ void BasicCameraComponent::captureLoop() {
             //int dataTypeSize = frame.elemSize();  
             //size_t frameSize = totalElements * dataTypeSize;
 
-            outputQueue.push(frame);
+            FramePacket packet;
+            packet.frameId = nextFrameId++;
+            packet.captureTime = FramePacket::Clock::now();
+            packet.frame = std::move(frame);
+            outputQueue.push(std::move(packet));
         }
 
         auto end = std::chrono::steady_clock::now();
@@ -89,8 +101,19 @@ void BasicCameraComponent::setSource(const std::string& source) {
     if (!cap.open(source)) {
         std::cerr << "Failed to change source: " << source << std::endl;
     } else {
+        reserveFramePool();
         startCapture();
         std::cout << "Changed source to: " << source << std::endl;
     }
 }
 
+
+// Preallocate one pool buffer per frame that can be alive along the pipeline at once
+void BasicCameraComponent::reserveFramePool() {
+    int width = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    int height = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    if (width <= 0 || height <= 0) {
+        return; // Sized from the first captured frame instead
+    }
+    FramePool::getInstance()->reserve(static_cast<size_t>(width) * height * 3, FRAME_POOL_SIZE);
+}
@@ -353,10 +353,10 @@ void PostProcessingComponent::postLoop(){
 
     while (running)
     {
-
-        parseHeadPose(FilePath);
-        parseEyeGaze(FilePath);
-        if (inputQueue.tryPop(carstate)) {
+        // Only re-read head pose and eye gaze when a new car state arrives
+        if (inputQueue.waitPopFor(carstate, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
+            parseHeadPose(FilePath);
+            parseEyeGaze(FilePath);
             std::cout << "Queue from post vehicle state: Steering angle " << carstate.steeringWheelAngle << ", Velocity " << carstate.velocity << std::endl;
             std::cout << "Head angle : " << headPose.headPoseAngle << ", eyegaze : " << eyeGaze.eyeGazeZone << std::endl;
             int ifAlert;
@@ -35,7 +35,7 @@ void BasicPreprocessingComponent::stopProcessing() {
 void BasicPreprocessingComponent::processingLoop() {
     cv::Mat frame;
     while (running) {
-        if (inputQueue.tryPop(frame)) {
+        if (inputQueue.waitPopFor(frame, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
             cv::Mat processedFrame = preprocessFrame(frame);
             if (!processedFrame.empty()) {
                 outputQueue.push(processedFrame);
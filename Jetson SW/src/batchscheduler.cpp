@@ -0,0 +1,80 @@
+#include "batchscheduler.h"
+#include <algorithm>
+#include <cstring>
+
+BatchScheduler::BatchScheduler(BatchRunner runner, size_t inputSize, size_t maxBatch, std::chrono::microseconds deadline)
+    : runner(runner), inputSize(inputSize), maxBatch(std::max<size_t>(maxBatch, 1)), deadline(deadline) {
+    worker = std::thread(&BatchScheduler::workerLoop, this);
+}
+
+BatchScheduler::~BatchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    requestCv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::future<std::vector<float>> BatchScheduler::submit(const float* input) {
+    Request request;
+    request.input = input;
+    request.submitted = std::chrono::steady_clock::now();
+    std::future<std::vector<float>> result = request.result.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        requests.push_back(std::move(request));
+    }
+    requestCv.notify_all();
+    return result;
+}
+
+size_t BatchScheduler::getBatchCount() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return batchCount;
+}
+
+double BatchScheduler::getAverageBatchSize() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return batchCount > 0 ? static_cast<double>(requestCount) / batchCount : 0.0;
+}
+
+void BatchScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        requestCv.wait(lock, [this] { return stopping || !requests.empty(); });
+        if (requests.empty()) {
+            break; // Stopping with nothing left to answer
+        }
+
+        // Hold the batch open until it is full or the first request has waited long enough
+        auto close = requests.front().submitted + deadline;
+        requestCv.wait_until(lock, close, [this] { return stopping || requests.size() >= maxBatch; });
+
+        size_t count = std::min(requests.size(), maxBatch);
+        std::vector<Request> batch;
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(requests.front()));
+            requests.pop_front();
+        }
+        batchCount++;
+        requestCount += count;
+        lock.unlock();
+
+        batchInput.resize(count * inputSize);
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(batchInput.data() + i * inputSize, batch[i].input, inputSize * sizeof(float));
+        }
+        bool ok = runner(batchInput.data(), count, batchOutput) && batchOutput.size() % count == 0 && !batchOutput.empty();
+        size_t outputSize = ok ? batchOutput.size() / count : 0;
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].result.set_value(std::vector<float>(batchOutput.begin() + i * outputSize,
+                                                         batchOutput.begin() + (i + 1) * outputSize));
+        }
+
+        lock.lock();
+    }
+}
@@ -6,6 +6,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <opencv2/opencv.hpp>
 #include <thread>
 #include <cstdint>
@@ -20,12 +21,13 @@ namespace pt = boost::posix_time;
 namespace gr = boost::gregorian;
 
 // Constructor
-CommTCPComponent::CommTCPComponent(int port, ThreadSafeQueue<cv::Mat>& outputQueue, 
-                                   ThreadSafeQueue<std::vector<std::vector<float>>>& readingsQueue, 
+CommTCPComponent::CommTCPComponent(int port, ThreadSafeQueue<FramePacket>& outputQueue, 
+                                   ThreadSafeQueue<Readings>& readingsQueue, 
                                    ThreadSafeQueue<std::string>& commandsQueue, 
-                                   ThreadSafeQueue<std::string>& faultsQueue)
+                                   ThreadSafeQueue<std::string>& faultsQueue,
+                                   LatencyTracker& latencyTracker)
     : port(port), outputQueue(outputQueue), readingsQueue(readingsQueue), 
-      commandsQueue(commandsQueue), faultsQueue(faultsQueue), running(false) {}
+      commandsQueue(commandsQueue), faultsQueue(faultsQueue), latencyTracker(latencyTracker), running(false) {}
 
 // Destructor
 CommTCPComponent::~CommTCPComponent() {
@@ -70,7 +72,12 @@ void CommTCPComponent::frameServerLoop() {
     listen(serverFd, 3);
     std::cout << "Frame server is ready and waiting for connections on port " << port << std::endl;
 
+    struct pollfd serverPoll = {serverFd, POLLIN, 0};
     while (running) {
+        // Sleep until a client connects instead of spinning on the non-blocking accept
+        if (poll(&serverPoll, 1, QUEUE_WAIT_TIMEOUT_MS) <= 0) {
+            continue;
+        }
         newSocket = accept(serverFd, NULL, NULL);
         if (newSocket > 0) {
             std::cout << "Client connected to frame server: socket FD " << newSocket << std::endl;
@@ -99,7 +106,12 @@ void CommTCPComponent::commandServerLoop() {
     listen(serverFd, 3);
     std::cout << "Command server is ready and waiting for connections on port " << (port + 1) << std::endl;
 
+    struct pollfd serverPoll = {serverFd, POLLIN, 0};
     while (running) {
+        // Sleep until a client connects instead of spinning on the non-blocking accept
+        if (poll(&serverPoll, 1, QUEUE_WAIT_TIMEOUT_MS) <= 0) {
+            continue;
+        }
         newSocket = accept(serverFd, NULL, NULL);
         if (newSocket > 0) {
             std::cout << "Client connected to command server: socket FD " << newSocket << std::endl;
@@ -114,11 +126,21 @@ void CommTCPComponent::commandServerLoop() {
 // Handle frame client connection
 void CommTCPComponent::handleFrameClient(int clientSocket) {
     try {
-        cv::Mat frame;
+        FramePacket packet;
+        cv::Mat annotatedFrame; // Reused between frames
         while (running) {
-            if (outputQueue.tryPop(frame) && !frame.empty()) {
+            if (outputQueue.waitPopFor(packet, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS)) && !packet.frame.empty()) {
                 std::vector<uchar> buffer;
-                cv::imencode(".jpg", frame, buffer);
+                packet.encodeStart = FramePacket::Clock::now();
+                // The face box is drawn on a copy, the frame itself stays as captured
+                if (packet.hasRoi) {
+                    packet.frame.copyTo(annotatedFrame);
+                    cv::rectangle(annotatedFrame, packet.roi, cv::Scalar(0, 255, 0), 2);
+                    cv::imencode(".jpg", annotatedFrame, buffer);
+                } else {
+                    cv::imencode(".jpg", packet.frame, buffer);
+                }
+                packet.encodeEnd = FramePacket::Clock::now();
                 auto bufferSize = htonl(buffer.size()); 
                 
                 ssize_t bytesSent = send(clientSocket, &bufferSize, sizeof(bufferSize), 0);
@@ -136,6 +158,8 @@ void CommTCPComponent::handleFrameClient(int clientSocket) {
                     throw std::runtime_error("Failed to send frame data");
                 }
                 totalFrameDataSent += bytesSent;
+                packet.sendEnd = FramePacket::Clock::now();
+                latencyTracker.record(packet);
             }
         }
         close(clientSocket);
@@ -145,15 +169,36 @@ void CommTCPComponent::handleFrameClient(int clientSocket) {
     }
 }
 
+// True when 'value' parses to a number outside [minValue, maxValue]. Malformed values are not out of
+// range here, they go on to the DMS manager which rejects them
+static bool outOfRange(const std::string& value, int minValue, int maxValue) {
+    try {
+        int parsed = std::stoi(value);
+        return parsed < minValue || parsed > maxValue;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
 // Handle command reception and readings data transmission to a client
 void CommTCPComponent::handleCommandClient(int clientSocket) {
     try {
-        std::vector<std::vector<float>> reading;
+        Readings reading;
+        std::vector<Readings> readingsBacklog;
+        std::vector<uint8_t> serializedData;
 
         while (running) {
-            // Handle readings data transmission
-            if (readingsQueue.tryPop(reading) && !reading.empty()) {
-                std::vector<uint8_t> serializedData = serialize(reading);
+            // Handle readings data transmission, the short wait keeps incoming commands responsive.
+            // Any backlog is taken under one lock and sent with a single send call
+            if (readingsQueue.waitPopFor(reading, std::chrono::milliseconds(COMMAND_POLL_TIMEOUT_MS))) {
+                readingsBacklog.clear();
+                readingsBacklog.push_back(reading);
+                readingsQueue.drain(readingsBacklog);
+
+                serializedData.clear();
+                for (const auto& backlogReading : readingsBacklog) {
+                    serialize(backlogReading, serializedData);
+                }
                 ssize_t bytesSent = send(clientSocket, serializedData.data(), serializedData.size(), 0);
                 if (bytesSent == -1 || bytesSent == 0) {
                     transmissionErrors++;
@@ -202,9 +247,8 @@ void CommTCPComponent::handleCommandClient(int clientSocket) {
                     if (message.find("SET_FPS") != std::string::npos) {
                         // Handle FPS configuration
                         std::cout << "Received SET_FPS command with value: " << message.substr(8) << std::endl;
-                        int fpsvalue = std::stoi(message.substr(8));
                         std::string command = "SET_FPS:" + message.substr(8);
-                        if(fpsvalue<MIN_FPS_THRESHOLD || fpsvalue>MAX_FPS_THRESHOLD)
+                        if(outOfRange(message.substr(8), MIN_FPS_THRESHOLD, MAX_FPS_THRESHOLD))
                         {
                             faultsQueue.push(command); //with the same command that should've been sent to DMS
                         }
@@ -226,8 +270,7 @@ void CommTCPComponent::handleCommandClient(int clientSocket) {
                         // Handle FDT configuration
                         std::cout << "Received SET_FDT command with value: " << message.substr(8) << std::endl;
                         std::string command = "SET_FDT:" + message.substr(8);
-                        int fdtvalue = std::stoi(message.substr(8));
-                        if(fdtvalue<MIN_FDT_THRESHOLD || fdtvalue>MAX_FDT_THRESHOLD)
+                        if(outOfRange(message.substr(8), MIN_FDT_THRESHOLD, MAX_FDT_THRESHOLD))
                         {
                             faultsQueue.push(command); //with the same command that should've been sent to DMS
                         }
@@ -252,10 +295,48 @@ void CommTCPComponent::handleCommandClient(int clientSocket) {
                         commandsQueue.push("SET_HP_MODEL:" + message.substr(13));
                         // Handle Eye Gaze Model
                     } else if (message.find("SET_EG_MODEL") != std::string::npos) {
-                        std::string command = "Clear Queue";
-                        commandsQueue.push(command);
                         std::cout << "Received SET_EG_MODEL command with value: " << message.substr(13) << std::endl;
                         commandsQueue.push("SET_EG_MODEL:" + message.substr(13));
+                        // Handle queue statistics logging
+                    } else if (message == "LOG_QUEUE_STATS") {
+                        std::cout << "Received LOG_QUEUE_STATS command" << std::endl;
+                        commandsQueue.push(message);
+                        // Handle queue capacity and overflow policy
+                    } else if (message.find("SET_QUEUE_POLICY") != std::string::npos) {
+                        std::cout << "Received SET_QUEUE_POLICY command with value: " << message.substr(17) << std::endl;
+                        commandsQueue.push("SET_QUEUE_POLICY:" + message.substr(17));
+                        // Handle live latency dump interval in seconds
+                    } else if (message.find("SET_LATENCY_DUMP") != std::string::npos) {
+                        std::cout << "Received SET_LATENCY_DUMP command with value: " << message.substr(17) << std::endl;
+                        commandsQueue.push("SET_LATENCY_DUMP:" + message.substr(17));
+                        // Handle AI backend change, cpu or tensorrt
+                    } else if (message.find("SET_AI_BACKEND") != std::string::npos) {
+                        std::cout << "Received SET_AI_BACKEND command with value: " << message.substr(15) << std::endl;
+                        commandsQueue.push("SET_AI_BACKEND:" + message.substr(15));
+                        // Handle model preloading, <head pose ids>;<eye gaze ids>
+                    } else if (message.find("PRELOAD_MODELS") != std::string::npos) {
+                        std::cout << "Received PRELOAD_MODELS command with value: " << message.substr(15) << std::endl;
+                        commandsQueue.push("PRELOAD_MODELS:" + message.substr(15));
+                        // Handle model cache budget in MB
+                    } else if (message.find("SET_MODEL_CACHE_MB") != std::string::npos) {
+                        std::cout << "Received SET_MODEL_CACHE_MB command with value: " << message.substr(19) << std::endl;
+                        commandsQueue.push("SET_MODEL_CACHE_MB:" + message.substr(19));
+                        // Handle inference batching, <max batch>,<deadline us>
+                    } else if (message.find("SET_AI_BATCHING") != std::string::npos) {
+                        std::cout << "Received SET_AI_BATCHING command with value: " << message.substr(16) << std::endl;
+                        commandsQueue.push("SET_AI_BATCHING:" + message.substr(16));
+                        // Handle face tracking between detections, <detect every N frames>,<min confidence %>
+                    } else if (message.find("SET_FD_TRACKING") != std::string::npos) {
+                        std::cout << "Received SET_FD_TRACKING command with value: " << message.substr(16) << std::endl;
+                        commandsQueue.push("SET_FD_TRACKING:" + message.substr(16));
+                        // Handle the face detection backend, a backend name or auto
+                    } else if (message.find("SET_FD_BACKEND") != std::string::npos) {
+                        std::cout << "Received SET_FD_BACKEND command with value: " << message.substr(15) << std::endl;
+                        commandsQueue.push("SET_FD_BACKEND:" + message.substr(15));
+                        // Handle the face search window, misses before a full-frame scan
+                    } else if (message.find("SET_FD_SEARCH") != std::string::npos) {
+                        std::cout << "Received SET_FD_SEARCH command with value: " << message.substr(14) << std::endl;
+                        commandsQueue.push("SET_FD_SEARCH:" + message.substr(14));
                     } else {
                         std::cout << "Received unknown command: " << message << std::endl;
                     }
@@ -269,29 +350,24 @@ void CommTCPComponent::handleCommandClient(int clientSocket) {
     }
 }
 
-// Serialize a 2D vector of floats to a byte array
-std::vector<uint8_t> CommTCPComponent::serialize(const std::vector<std::vector<float>>& data) {
-    std::vector<uint8_t> buffer;
-    size_t rows = data.size();
-    size_t cols = rows > 0 ? data[0].size() : 0;
+// Serialize one frame's readings and append them to a byte array. The wire format is unchanged for
+// the desktop app: rows (2) and cols (9) as size_t, then head pose and eye gaze as floats
+void CommTCPComponent::serialize(const Readings& readings, std::vector<uint8_t>& buffer) {
+    const size_t rows = 2;
+    const size_t cols = READINGS_VALUE_COUNT;
 
-    // Add size information
-    buffer.resize(sizeof(size_t) * 2 + rows * cols * sizeof(float));
-    uint8_t* ptr = buffer.data();
+    size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(size_t) * 2 + sizeof(readings.headPose) + sizeof(readings.eyeGaze));
+    uint8_t* ptr = buffer.data() + offset;
 
-    // Copy rows and cols to the buffer
     std::memcpy(ptr, &rows, sizeof(size_t));
     ptr += sizeof(size_t);
     std::memcpy(ptr, &cols, sizeof(size_t));
     ptr += sizeof(size_t);
 
-    // Copy each float value to the buffer
-    for (const auto& row : data) {
-        std::memcpy(ptr, row.data(), row.size() * sizeof(float));
-        ptr += row.size() * sizeof(float);
-    }
-
-    return buffer;
+    std::memcpy(ptr, readings.headPose.data(), sizeof(readings.headPose));
+    ptr += sizeof(readings.headPose);
+    std::memcpy(ptr, readings.eyeGaze.data(), sizeof(readings.eyeGaze));
 }
 
 // Log data transfer metrics
@@ -1,23 +1,30 @@
 #include "dmsmanager.h"
 #include <benchmark/benchmark.h>
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+namespace pt = boost::posix_time;
+namespace gr = boost::gregorian;
 
 // Constructor: passes input and output queues for different components
-DMSManager::DMSManager(ThreadSafeQueue<cv::Mat>& cameraQueue, 
-                       ThreadSafeQueue<cv::Mat>& faceDetectionQueue, 
-                       ThreadSafeQueue<cv::Rect>& faceRectQueue,
-                       ThreadSafeQueue<std::vector<std::vector<float>>>& AIDetectionQueue, 
-                       ThreadSafeQueue<cv::Mat>& framesQueue, 
+DMSManager::DMSManager(ThreadSafeQueue<FramePacket>& cameraQueue, 
+                       ThreadSafeQueue<FramePacket>& faceDetectionQueue, 
+                       ThreadSafeQueue<Readings>& AIDetectionQueue, 
+                       ThreadSafeQueue<FramePacket>& framesQueue, 
                        ThreadSafeQueue<cv::Mat>& tcpOutputQueue, 
                        int tcpPort, 
                        ThreadSafeQueue<std::string>& commandsQueue,
                        ThreadSafeQueue<std::string>& faultsQueue)
     : cameraComponent(cameraQueue, commandsQueue, faultsQueue),
-      faceDetectionComponent(cameraQueue, faceDetectionQueue, faceRectQueue, commandsQueue, faultsQueue),
-      AiComponent(faceDetectionQueue, faceRectQueue, AIDetectionQueue, framesQueue, commandsQueue, faultsQueue),
-      tcpComponent(tcpPort, framesQueue, AIDetectionQueue, commandsQueue, faultsQueue),
+      faceDetectionComponent(cameraQueue, faceDetectionQueue, commandsQueue, faultsQueue),
+      AiComponent(faceDetectionQueue, AIDetectionQueue, framesQueue, commandsQueue, faultsQueue),
+      tcpComponent(tcpPort, framesQueue, AIDetectionQueue, commandsQueue, faultsQueue, latencyTracker),
       cameraQueue(cameraQueue), 
       faceDetectionQueue(faceDetectionQueue), 
-      faceRectQueue(faceRectQueue),
       AIDetectionQueue(AIDetectionQueue),
       framesQueue(framesQueue), 
       tcpPort(tcpPort), 
@@ -25,11 +32,17 @@ DMSManager::DMSManager(ThreadSafeQueue<cv::Mat>& cameraQueue,
       commandsQueue(commandsQueue),
       faultsQueue(faultsQueue),
       running(false), 
-      firstRun(true) {}
+      firstRun(true) {
+    configureQueues();
+}
 
 // Destructor (cleanup)
 DMSManager::~DMSManager() {
     stopSystem();
+    tcpComponent.stopServer();
+    commandsQueue.close();  // Wakes the commands loop so its thread can be joined
+    if (commandsThread.joinable()) commandsThread.join();
+    if (tcpThread.joinable()) tcpThread.join();
 }
 
 // Startup system
@@ -37,6 +50,10 @@ bool DMSManager::startSystem() {
     if (running) return false;  // Prevent the system from starting if it's already running
     running = true;
 
+    // Accept frames again after a previous stopSystem()
+    cameraQueue.reopen();
+    faceDetectionQueue.reopen();
+
     if (firstRun) {
         // Starting each component in its own thread
         cameraThread = std::thread(&DMSManager::cameraLoop, this);  // Start the camera loop in its own thread
@@ -44,6 +61,7 @@ bool DMSManager::startSystem() {
         AIThread = std::thread(&DMSManager::AILoop, this);  // Start AI detection in its own thread
         tcpThread = std::thread(&DMSManager::commtcpLoop, this); // Start tcp thread in its own thread
         commandsThread = std::thread(&DMSManager::commandsLoop, this); // Start commands thread in its own thread
+        commandsQueue.push("PRELOAD_MODELS:" MODEL_PRELOAD_AT_STARTUP);
         firstRun = false;
         return true;
     } else {
@@ -61,10 +79,17 @@ void DMSManager::stopSystem() {
     running = false;  // Signal all loops to stop
     clearQueues();
 
+    // Wake the face detection and AI loops waiting on their input queues
+    cameraQueue.close();
+    faceDetectionQueue.close();
+
     // Log performance metrics
     AiComponent.logPerformanceMetrics();
     tcpComponent.logDataTransferMetrics();
     faceDetectionComponent.logPerformanceMetrics();
+    logQueueMetrics();
+    latencyTracker.logLatencyMetrics();
+    FramePool::getInstance()->logPoolMetrics();
 
     // Stop components
     cameraComponent.stopCapture();
@@ -105,11 +130,10 @@ void DMSManager::commtcpLoop() {
 // Loop for DMSManager component to check for any needed commands by components
 void DMSManager::commandsLoop(){
     std::string command;
-    while (true) {
-        if (commandsQueue.tryPop(command)) {
-            std::cout << "Received command in the DMS manager: " << command << std::endl;
-            this->handleCommand(command);
-        }
+    // Blocks until a command arrives, returns once the queue is closed on shutdown
+    while (commandsQueue.waitAndPop(command)) {
+        std::cout << "Received command in the DMS manager: " << command << std::endl;
+        this->handleCommand(command);
     }
 }
 
@@ -130,14 +154,146 @@ void DMSManager::setCamereSource(const std::string& source) {
 void DMSManager::clearQueues(){
     cameraQueue.clear();
     faceDetectionQueue.clear();
-    faceRectQueue.clear();
     AIDetectionQueue.clear();
     framesQueue.clear();
     tcpOutputQueue.clear();
 }
 
+// Frame links are mailboxes: each stage only ever wants the newest frame, so end-to-end latency
+// is bounded by one frame period instead of by queue depth. Commands and faults are never dropped.
+void DMSManager::configureQueues() {
+    cameraQueue.makeMailbox();
+    faceDetectionQueue.makeMailbox();
+    framesQueue.makeMailbox();
+    setQueuePolicy("AIDetection", 4, OverflowPolicy::DropOldest);
+    setQueuePolicy("tcpOutput", 2, OverflowPolicy::DropOldest);
+    setQueuePolicy("commands", 0, OverflowPolicy::Block);
+    setQueuePolicy("faults", 0, OverflowPolicy::Block);
+}
+
+bool DMSManager::setQueuePolicy(const std::string& queueName, size_t capacity, OverflowPolicy policy) {
+    bool applied;
+    if (queueName == "camera") applied = cameraQueue.setCapacity(capacity, policy);
+    else if (queueName == "faceDetection") applied = faceDetectionQueue.setCapacity(capacity, policy);
+    else if (queueName == "AIDetection") applied = AIDetectionQueue.setCapacity(capacity, policy);
+    else if (queueName == "frames") applied = framesQueue.setCapacity(capacity, policy);
+    else if (queueName == "tcpOutput") applied = tcpOutputQueue.setCapacity(capacity, policy);
+    else if (queueName == "commands") applied = commandsQueue.setCapacity(capacity, policy);
+    else if (queueName == "faults") applied = faultsQueue.setCapacity(capacity, policy);
+    else {
+        std::cerr << "Unknown queue name: " << queueName << std::endl;
+        return false;
+    }
+    if (!applied) {
+        std::cerr << "Queue " << queueName << " is lock-free, it keeps its ring capacity and only takes Block or DropNewest." << std::endl;
+    }
+    return applied;
+}
+
+bool DMSManager::setQueueLockFree(const std::string& queueName, size_t capacity) {
+    if (running) {
+        std::cerr << "Queue backend can only be changed before the system starts." << std::endl;
+        return false;
+    }
+    if (queueName != "camera") {
+        std::cerr << "Queue " << queueName << " is not a single-producer/single-consumer link." << std::endl;
+        return false;
+    }
+    if (!cameraQueue.enableLockFree(capacity)) {
+        std::cerr << "Queue " << queueName << " is already lock-free or not on a Block or DropNewest policy." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Write one queue's snapshot in the benchmark log format
+static void writeQueueStats(std::ofstream& logFile, const std::string& name, const QueueStats& stats) {
+    logFile << name << " Queue:\n";
+    logFile << "Depth: " << stats.depth << "\n";
+    logFile << (stats.mailbox ? "Overwritten Items: " : "Dropped Items: ") << stats.droppedCount << "\n";
+    if (!stats.instrumented) {
+        return;
+    }
+    logFile << "Peak Depth: " << stats.peakDepth << "\n";
+    logFile << "Push Rate: " << stats.pushRate << " items/s\n";
+    logFile << "Pop Rate: " << stats.popRate << " items/s\n";
+    logFile << "Producer Wait Time: " << stats.producerWaitMs << " ms\n";
+    logFile << "Consumer Wait Time: " << stats.consumerWaitMs << " ms\n";
+    logFile << "Dwell Time Histogram:";
+    for (int i = 0; i < QUEUE_DWELL_BUCKETS; ++i) {
+        if (i < QUEUE_DWELL_BUCKETS - 1) {
+            logFile << " <=" << QUEUE_DWELL_BOUNDS_MS[i] << "ms:" << stats.dwellHistogram[i];
+        } else {
+            logFile << " >" << QUEUE_DWELL_BOUNDS_MS[i - 1] << "ms:" << stats.dwellHistogram[i];
+        }
+    }
+    logFile << "\n";
+}
+
+// Log depth and dropped items per queue, plus rates, wait times and dwell times when the
+// queues are built with QUEUE_INSTRUMENTATION
+void DMSManager::logQueueMetrics() {
+    fs::path dir("benchmarklogs");
+    if (!fs::exists(dir)) {
+        fs::create_directory(dir);
+    }
+
+    pt::ptime now = pt::second_clock::local_time();
+    std::ostringstream filename;
+    filename << dir.string() << "/benchmark_log_"
+             << gr::to_iso_extended_string(now.date()) << "_"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().hours() << "-"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().minutes()
+             << ".txt";
+
+    std::ofstream logFile(filename.str(), std::ios::app);
+
+    logFile << "Queue Metrics:\n";
+    writeQueueStats(logFile, "camera", cameraQueue.getStats());
+    writeQueueStats(logFile, "faceDetection", faceDetectionQueue.getStats());
+    writeQueueStats(logFile, "AIDetection", AIDetectionQueue.getStats());
+    writeQueueStats(logFile, "frames", framesQueue.getStats());
+    writeQueueStats(logFile, "tcpOutput", tcpOutputQueue.getStats());
+    writeQueueStats(logFile, "commands", commandsQueue.getStats());
+    writeQueueStats(logFile, "faults", faultsQueue.getStats());
+    logFile << "<<------------------------------------------------------------------->>\n";
+    logFile.close();
+
+    cameraQueue.resetStats();
+    faceDetectionQueue.resetStats();
+    AIDetectionQueue.resetStats();
+    framesQueue.resetStats();
+    tcpOutputQueue.resetStats();
+    commandsQueue.resetStats();
+    faultsQueue.resetStats();
+}
+
+// Parse the policy names used by the SET_QUEUE_POLICY command
+static bool parseOverflowPolicy(const std::string& name, OverflowPolicy& policy) {
+    if (name == "block") policy = OverflowPolicy::Block;
+    else if (name == "drop_oldest") policy = OverflowPolicy::DropOldest;
+    else if (name == "drop_newest") policy = OverflowPolicy::DropNewest;
+    else if (name == "keep_latest") policy = OverflowPolicy::KeepLatest;
+    else return false;
+    return true;
+}
+
+bool DMSManager::parseCommandInt(const std::string& command, const std::string& text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        if (used == text.size()) {
+            return true;
+        }
+    } catch (const std::exception&) {
+        // std::invalid_argument or std::out_of_range, reported below
+    }
+    std::cerr << "Invalid numeric value '" << text << "' in command: " << command << std::endl;
+    faultsQueue.push("Command_fault:" + command);
+    return false;
+}
+
 void DMSManager::handleCommand(std::string& command) {
-    clearQueues();
     //model paths
     std::map<std::string, std::string> headPoseModels = {
         {"AX", "/home/dms/DMS/ModularCode/include/Ax.engine"},
@@ -172,7 +328,10 @@ void DMSManager::handleCommand(std::string& command) {
         size_t pos = command.find(":");
         if (pos != std::string::npos) {
             std::string fpsValueStr = command.substr(pos + 1);
-            int fpsValue = std::stoi(fpsValueStr);
+            int fpsValue;
+            if (!parseCommandInt(command, fpsValueStr, fpsValue)) {
+                return;
+            }
             std::cout << "Setting FPS to: " << fpsValue << std::endl;
             setCameraFPS(fpsValue);
         } else {
@@ -184,7 +343,10 @@ void DMSManager::handleCommand(std::string& command) {
         size_t pos = command.find(":");
         if (pos != std::string::npos) {
             std::string fdtValueStr = command.substr(pos + 1);
-            int fdtValue = std::stoi(fdtValueStr);
+            int fdtValue;
+            if (!parseCommandInt(command, fdtValueStr, fdtValue)) {
+                return;
+            }
             std::cout << "Setting Face Detection Threshold to: " << fdtValue << std::endl;
             setFaceFDT(fdtValue);
         } else {
@@ -242,6 +404,10 @@ void DMSManager::handleCommand(std::string& command) {
     else if (command == "Clear Queue") {
         clearQueues();
     }
+    // Write the queue metrics collected so far without stopping the system
+    else if (command == "LOG_QUEUE_STATS") {
+        logQueueMetrics();
+    }
     // Handling Face Detection Model
     else if (command.find("SET_FD_MODEL:") != std::string::npos) {
         size_t pos = command.find(":");
@@ -278,9 +444,7 @@ void DMSManager::handleCommand(std::string& command) {
             std::string modelValue = command.substr(pos + 1);
             std::cout << "Setting Head Pose Model to: " << modelValue << std::endl;
             if (headPoseModels.find(modelValue) != headPoseModels.end()) {
-                clearQueues();
                 AiComponent.updateHeadPoseEngine(headPoseModels[modelValue]);
-                clearQueues();
             } else {
                 std::cerr << "Head pose model identifier not recognized: " << modelValue << std::endl;
             }
@@ -295,15 +459,143 @@ void DMSManager::handleCommand(std::string& command) {
             std::string modelValue = command.substr(pos + 1);
             std::cout << "Setting Eye Gaze Model to: " << modelValue << std::endl;
             if (eyeGazeModels.find(modelValue) != eyeGazeModels.end()) {
-                clearQueues();
                 AiComponent.updateEyeGazeEngine(eyeGazeModels[modelValue]);
-                clearQueues();
             } else {
                 std::cerr << "Eye gaze model identifier not recognized: " << modelValue << std::endl;
             }
         } else {
             std::cerr << "Invalid SET_EG_MODEL command format: " << command << std::endl;
         }
+    }
+    // Setting queue capacity and overflow policy, format SET_QUEUE_POLICY:<queue>,<capacity>,<policy>
+    else if (command.find("SET_QUEUE_POLICY:") != std::string::npos) {
+        std::istringstream args(command.substr(command.find(":") + 1));
+        std::string queueName, capacityStr, policyStr;
+        OverflowPolicy policy;
+        if (std::getline(args, queueName, ',') && std::getline(args, capacityStr, ',') &&
+            std::getline(args, policyStr) && parseOverflowPolicy(policyStr, policy)) {
+            int capacityValue;
+            if (!parseCommandInt(command, capacityStr, capacityValue)) {
+                return;
+            }
+            if (capacityValue < 0) {
+                std::cerr << "Queue capacity must not be negative: " << capacityValue << std::endl;
+                return;
+            }
+            size_t capacity = static_cast<size_t>(capacityValue);
+            if (setQueuePolicy(queueName, capacity, policy)) {
+                std::cout << "Queue " << queueName << " capacity set to " << capacity
+                          << " with policy " << policyStr << std::endl;
+            }
+        } else {
+            std::cerr << "Invalid SET_QUEUE_POLICY command format: " << command << std::endl;
+        }
+    }
+    // Setting the live latency dump interval in seconds, 0 disables it
+    else if (command.find("SET_LATENCY_DUMP:") != std::string::npos) {
+        int seconds;
+        if (!parseCommandInt(command, command.substr(command.find(":") + 1), seconds)) {
+            return;
+        }
+        std::cout << "Setting live latency dump interval to: " << seconds << " s" << std::endl;
+        latencyTracker.setLiveDumpInterval(seconds);
+    }
+    // Preloading models into the model cache, format PRELOAD_MODELS:<head pose ids>;<eye gaze ids>
+    else if (command.find("PRELOAD_MODELS:") != std::string::npos) {
+        std::string value = command.substr(command.find(":") + 1);
+        size_t separator = value.find(";");
+        std::istringstream headPoseIds(value.substr(0, separator));
+        std::istringstream eyeGazeIds(separator != std::string::npos ? value.substr(separator + 1) : "");
+        std::vector<std::string> headPosePaths, eyeGazePaths;
+        std::string id;
+        while (std::getline(headPoseIds, id, ',')) {
+            if (headPoseModels.count(id) && id != "No Head Pose") {
+                headPosePaths.push_back(headPoseModels[id]);
+            } else if (!id.empty()) {
+                std::cerr << "Head pose model identifier not recognized: " << id << std::endl;
+            }
+        }
+        while (std::getline(eyeGazeIds, id, ',')) {
+            if (eyeGazeModels.count(id) && id != "No Eye Gaze") {
+                eyeGazePaths.push_back(eyeGazeModels[id]);
+            } else if (!id.empty()) {
+                std::cerr << "Eye gaze model identifier not recognized: " << id << std::endl;
+            }
+        }
+        std::cout << "Preloading " << headPosePaths.size() << " head pose and "
+                  << eyeGazePaths.size() << " eye gaze models" << std::endl;
+        AiComponent.preloadModels(headPosePaths, eyeGazePaths);
+    }
+    // Setting inference micro-batching, format SET_AI_BATCHING:<max batch>,<deadline us>, max batch 1 turns it off
+    else if (command.find("SET_AI_BATCHING:") != std::string::npos) {
+        std::istringstream args(command.substr(command.find(":") + 1));
+        std::string batchStr, deadlineStr;
+        if (std::getline(args, batchStr, ',') && std::getline(args, deadlineStr)) {
+            int maxBatch, deadlineUs;
+            if (!parseCommandInt(command, batchStr, maxBatch) || !parseCommandInt(command, deadlineStr, deadlineUs)) {
+                return;
+            }
+            std::cout << "Setting AI batching to " << maxBatch << " requests within " << deadlineUs << " us" << std::endl;
+            AiComponent.setBatching(static_cast<size_t>(std::max(maxBatch, 0)), deadlineUs);
+        } else {
+            std::cerr << "Invalid SET_AI_BATCHING command format: " << command << std::endl;
+        }
+    }
+    // Setting face tracking, format SET_FD_TRACKING:<detect every N frames>,<min confidence %>, N of 1 turns it off
+    else if (command.find("SET_FD_TRACKING:") != std::string::npos) {
+        std::istringstream args(command.substr(command.find(":") + 1));
+        std::string everyStr, confidenceStr;
+        if (std::getline(args, everyStr, ',') && std::getline(args, confidenceStr)) {
+            int detectEvery, minConfidence;
+            if (!parseCommandInt(command, everyStr, detectEvery) || !parseCommandInt(command, confidenceStr, minConfidence)) {
+                return;
+            }
+            if (minConfidence < 0 || minConfidence > 100) {
+                std::cerr << "Tracking confidence out of range: " << minConfidence << std::endl;
+            } else {
+                faceDetectionComponent.setTracking(detectEvery, minConfidence);
+            }
+        } else {
+            std::cerr << "Invalid SET_FD_TRACKING command format: " << command << std::endl;
+        }
+    }
+    // Setting the face detection backend, format SET_FD_BACKEND:<cuda|cuda_fp16|opencv|opencl|opencl_fp16|auto>
+    else if (command.find("SET_FD_BACKEND:") != std::string::npos) {
+        std::string backendValue = command.substr(command.find(":") + 1);
+        std::cout << "Setting face detection backend to: " << backendValue << std::endl;
+        faceDetectionComponent.stopDetection();
+        if (!faceDetectionComponent.setBackend(backendValue)) {
+            std::cerr << "Failed to set face detection backend: " << backendValue << std::endl;
+        }
+        faceDetectionComponent.startDetection();
+    }
+    // Setting the face search window, format SET_FD_SEARCH:<misses before a full-frame scan>, 0 turns it off
+    else if (command.find("SET_FD_SEARCH:") != std::string::npos) {
+        int maxMisses;
+        if (!parseCommandInt(command, command.substr(command.find(":") + 1), maxMisses)) {
+            return;
+        }
+        faceDetectionComponent.setSearchWindow(maxMisses);
+    }
+    // Setting the model cache memory budget in MB
+    else if (command.find("SET_MODEL_CACHE_MB:") != std::string::npos) {
+        int budget;
+        if (!parseCommandInt(command, command.substr(command.find(":") + 1), budget)) {
+            return;
+        }
+        std::cout << "Setting model cache budget to: " << budget << " MB" << std::endl;
+        AiComponent.setModelCacheBudget(static_cast<size_t>(std::max(budget, 0)));
+    }
+    // Setting the head pose and eye gaze inference backend, format SET_AI_BACKEND:cpu or SET_AI_BACKEND:tensorrt
+    else if (command.find("SET_AI_BACKEND:") != std::string::npos) {
+        std::string backendValue = command.substr(command.find(":") + 1);
+        std::cout << "Setting AI backend to: " << backendValue << std::endl;
+        if (backendValue == "cpu" || backendValue == "tensorrt") {
+            AiComponent.updateInferenceBackend(backendValue == "cpu" ? InferenceBackendType::CPU
+                                                                     : InferenceBackendType::TensorRT);
+        } else {
+            std::cerr << "AI backend not recognized: " << backendValue << std::endl;
+        }
     } else {
         std::cerr << "Unknown command: " << command << std::endl;
     }
@@ -44,7 +44,7 @@ void EyeGazeComponent::EyeGazeDetectionLoop() {
     this->lastTime = std::chrono::high_resolution_clock::now(); // Initialize the last time
     bool isFirstFrame = true; // Flag to check if it's the first frame
     while (running) {
-        if (inputQueue.tryPop(frame)) {
+        if (inputQueue.waitPopFor(frame, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
 
             //std::cout << "about to start eye gaze" << std::endl;
 
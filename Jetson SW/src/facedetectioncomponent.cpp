@@ -3,6 +3,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp> 
 #include <boost/date_time/gregorian/gregorian.hpp> 
 #include <iomanip> 
+#include <cmath>
 
 
 namespace fs = boost::filesystem;
@@ -10,12 +11,11 @@ namespace pt = boost::posix_time;
 namespace gr = boost::gregorian;
 
 // Constructor
-FaceDetectionComponent::FaceDetectionComponent(ThreadSafeQueue<cv::Mat>& inputQueue, 
-                                               ThreadSafeQueue<cv::Mat>& outputQueue,
-                                               ThreadSafeQueue<cv::Rect>& faceRectQueue,
+FaceDetectionComponent::FaceDetectionComponent(ThreadSafeQueue<FramePacket>& inputQueue, 
+                                               ThreadSafeQueue<FramePacket>& outputQueue,
                                                ThreadSafeQueue<std::string>& commandsQueue,
                                                ThreadSafeQueue<std::string>& faultsQueue)
-    : inputQueue(inputQueue), outputQueue(outputQueue), faceRectQueue(faceRectQueue), 
+    : inputQueue(inputQueue), outputQueue(outputQueue), 
       commandsQueue(commandsQueue), faultsQueue(faultsQueue), running(false){}
 
 // Destructor
@@ -24,21 +24,159 @@ FaceDetectionComponent::~FaceDetectionComponent() {
 }
 
 
+// DNN backends and targets face detection can run on
+struct FaceDetectionBackend {
+    const char* name;
+    cv::dnn::Backend backend;
+    cv::dnn::Target target;
+};
+
+static const FaceDetectionBackend faceDetectionBackends[] = {
+#ifndef DMS_CPU_ONLY
+    {"cuda", cv::dnn::DNN_BACKEND_CUDA, cv::dnn::DNN_TARGET_CUDA},
+    {"cuda_fp16", cv::dnn::DNN_BACKEND_CUDA, cv::dnn::DNN_TARGET_CUDA_FP16},
+#endif
+    {"opencv", cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_CPU},
+    {"opencl", cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_OPENCL},
+    {"opencl_fp16", cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_OPENCL_FP16},
+};
+
+static const FaceDetectionBackend* findBackend(const std::string& name) {
+    for (const auto& candidate : faceDetectionBackends) {
+        if (name == candidate.name) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+// OpenCV falls back to the CPU without an error when a backend is missing from the build, ask first
+static bool isAvailable(const FaceDetectionBackend& candidate) {
+    std::vector<cv::dnn::Target> targets = cv::dnn::getAvailableTargets(candidate.backend);
+    return std::find(targets.begin(), targets.end(), candidate.target) != targets.end();
+}
+
+// Average forward time of 'net' on a blank full-frame input, in ms
+static double timeForward(cv::dnn::Net& net) {
+    cv::Mat frame(480, 640, CV_8UC3, cv::Scalar(128, 128, 128));
+    cv::Mat blob;
+    cv::dnn::blobFromImage(frame, blob, 1 / 255.0, cv::Size(FACE_DETECT_INPUT_SIZE, FACE_DETECT_INPUT_SIZE),
+                           cv::Scalar(0, 0, 0), true, false);
+    std::vector<cv::Mat> outs;
+    for (int i = 0; i < FACE_BACKEND_WARMUP_RUNS; ++i) {
+        net.setInput(blob);
+        net.forward(outs, net.getUnconnectedOutLayersNames());
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < FACE_BACKEND_TIMED_RUNS; ++i) {
+        net.setInput(blob);
+        net.forward(outs, net.getUnconnectedOutLayersNames());
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / FACE_BACKEND_TIMED_RUNS;
+}
+
 // Initialize model, choose backend (CUDA, OPENCV, OPENCL)
 bool FaceDetectionComponent::initialize(const std::string& modelConfiguration, const std::string& modelWeights) {
-    net = cv::dnn::readNetFromDarknet(modelConfiguration, modelWeights);
-    net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-    net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-    if (net.empty()) {
-        std::cerr << "Failed to load the model or config file." << std::endl;
-        std::string command = "FaceDet_fault"
-        faultsQueue.push(command);
-        return false;
+    configPath = modelConfiguration;
+    weightsPath = modelWeights;
+    nets.clear();
+
+    std::string name = backendName == "auto" ? autotuneBackend() : backendName;
+    const FaceDetectionBackend* chosen = findBackend(name);
+    if (!chosen || !isAvailable(*chosen)) {
+        std::cerr << "Face detection backend " << name << " is not available, using opencv" << std::endl;
+        chosen = findBackend("opencv");
+    }
+
+    for (int i = 0; i < workerCount; ++i) {
+        cv::dnn::Net net = cv::dnn::readNetFromDarknet(modelConfiguration, modelWeights);
+        net.setPreferableBackend(chosen->backend);
+        net.setPreferableTarget(chosen->target);
+        if (net.empty()) {
+            std::cerr << "Failed to load the model or config file." << std::endl;
+            std::string command = "FaceDet_fault";
+            faultsQueue.push(command);
+            nets.clear();
+            return false;
+        }
+        nets.push_back(net);
     }
+    activeBackend = chosen->name;
+    try {
+        activeBackendLatency = timeForward(nets[0]); // Also warms the first network up
+    } catch (const cv::Exception& e) {
+        std::cerr << "OpenCV error: " << e.what() << std::endl;
+        activeBackendLatency = 0;
+    }
+    std::cout << "Face detection running on " << activeBackend << ", " << activeBackendLatency << " ms per frame" << std::endl;
     commandsQueue.push("Clear Queue");
     return true;
 }
 
+bool FaceDetectionComponent::setBackend(const std::string& name) {
+    if (name != "auto" && !findBackend(name)) {
+        std::cerr << "Face detection backend not recognized: " << name << std::endl;
+        return false;
+    }
+    backendName = name;
+    if (configPath.empty()) {
+        return true; // Applied when a model is loaded
+    }
+    return initialize(configPath, weightsPath);
+}
+
+std::string FaceDetectionComponent::autotuneBackend() {
+    std::ostringstream table;
+    table << "Backend | Available | Average Forward (ms)\n";
+    std::string fastest = "opencv";
+    double fastestTime = std::numeric_limits<double>::max();
+    for (const auto& candidate : faceDetectionBackends) {
+        if (!isAvailable(candidate)) {
+            table << candidate.name << " | no | -\n";
+            continue;
+        }
+        try {
+            cv::dnn::Net net = cv::dnn::readNetFromDarknet(configPath, weightsPath);
+            net.setPreferableBackend(candidate.backend);
+            net.setPreferableTarget(candidate.target);
+            double averageTime = timeForward(net);
+            table << candidate.name << " | yes | " << averageTime << "\n";
+            if (averageTime < fastestTime) {
+                fastestTime = averageTime;
+                fastest = candidate.name;
+            }
+        } catch (const cv::Exception& e) {
+            std::cerr << "Face detection backend " << candidate.name << " failed: " << e.what() << std::endl;
+            table << candidate.name << " | failed | -\n";
+        }
+    }
+
+    // Ensure the directory exists
+    fs::path dir("benchmarklogs");
+    if (!fs::exists(dir)) {
+        fs::create_directory(dir);
+    }
+
+    // Get current time and format the filename
+    pt::ptime now = pt::second_clock::local_time();
+    std::ostringstream filename;
+    filename << dir.string() << "/benchmark_log_"
+             << gr::to_iso_extended_string(now.date()) << "_"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().hours() << "-"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().minutes()
+             << ".txt";
+
+    // Open the log file in append mode
+    std::ofstream logFile(filename.str(), std::ios::app);
+    logFile << "Face Detection Backend Autotune (" << configPath << "):\n";
+    logFile << table.str();
+    logFile << "Chosen Backend: " << fastest << "\n";
+    logFile << "<<------------------------------------------------------------------->>\n";
+    logFile.close();
+    return fastest;
+}
+
 
 // Start detection loop in another thread
 void FaceDetectionComponent::startDetection() {
@@ -48,78 +186,257 @@ void FaceDetectionComponent::startDetection() {
     }
     running = true;
     commandsQueue.push("Clear Queue");
+    workersRunning = true;
+    for (size_t i = 0; i < nets.size(); ++i) {
+        workers.emplace_back(&FaceDetectionComponent::workerLoop, this, i);
+    }
     detectionThread = std::thread(&FaceDetectionComponent::detectionLoop, this);
 }
 
 // Release thread and any needed cleanup
 void FaceDetectionComponent::stopDetection() {
-    running = false;
+    {
+        std::lock_guard<std::mutex> lock(pipelineMtx);
+        running = false;
+    }
+    slotCv.notify_all();
     if (detectionThread.joinable()) {
         detectionThread.join();
     }
+    {
+        std::lock_guard<std::mutex> lock(pipelineMtx);
+        workersRunning = false;
+    }
+    workCv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Frames still in the stage are dropped, the queues are cleared around a restart anyway
+    std::lock_guard<std::mutex> lock(pipelineMtx);
+    pendingJobs.clear();
+    inFlight.clear();
+    detectionsInFlight = 0;
 }
 
 void FaceDetectionComponent::detectionLoop() {
-    cv::Mat frame;
+    FramePacket packet;
     lastTime = std::chrono::high_resolution_clock::now();
     commandsQueue.push("Clear Queue");
     while (running) {
-        if (inputQueue.tryPop(frame)) {
-            if (!modelstatus) {
-                outputQueue.push(frame);
-                continue;
+        if (!inputQueue.waitPopFor(packet, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
+            continue;
+        }
+        std::shared_ptr<DetectionJob> job = std::make_shared<DetectionJob>();
+        job->packet = std::move(packet);
+        FramePacket& current = job->packet;
+
+        std::unique_lock<std::mutex> lock(pipelineMtx);
+        if (!modelstatus || nets.empty()) {
+            // Still in order behind any detection in flight
+            job->done = true;
+            inFlight.push_back(job);
+            flushLocked();
+            continue;
+        }
+        current.faceDetectionStart = FramePacket::Clock::now();
+
+        // Track first, also on frames due for detection so the drift can be measured. While a
+        // detection is in flight the tracker still follows the template of the one before
+        int detectEvery = skipRate.load();
+        double confidence = 0;
+        if (detectEvery > 1 && tracker.isTracking()) {
+            auto trackStart = std::chrono::high_resolution_clock::now();
+            job->tracked = tracker.track(current.frame, job->trackedRoi, confidence);
+            double trackingTime = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - trackStart).count();
+            trackingRuns++;
+            totalTrackingTime += trackingTime;
+            maxTrackingTime = std::max(maxTrackingTime, trackingTime);
+        }
+
+        bool due = frameCounter + 1 >= detectEvery || !tracker.isTracking();
+        if (!due && (!job->tracked || confidence * 100 < trackConfidence.load())) {
+            lowConfidenceDetections++;
+            due = true;
+        }
+
+        if (!due) {
+            frameCounter++;
+            trackedFrames++;
+            current.faceSearched = true;
+            current.roi = job->trackedRoi;
+            current.hasRoi = true;
+            lastFace = job->trackedRoi;
+            current.faceDetectionEnd = FramePacket::Clock::now();
+            job->done = true;
+        } else {
+            // One detection per worker, wait here rather than queue frames behind a busy network
+            slotCv.wait(lock, [this] { return !running || detectionsInFlight < static_cast<int>(nets.size()); });
+            if (!running) {
+                break;
+            }
+            job->detect = true;
+            job->area = nextSearchArea(current.frame, job->inputSize);
+            frameCounter = 0;
+            detectionsInFlight++;
+            maxDetectionsInFlight = std::max(maxDetectionsInFlight, detectionsInFlight);
+            pendingJobs.push_back(job);
+            workCv.notify_one();
+        }
+        inFlight.push_back(job);
+        flushLocked();
+    }
+}
+
+void FaceDetectionComponent::workerLoop(size_t index) {
+    cv::dnn::Net& net = nets[index];
+    std::unique_lock<std::mutex> lock(pipelineMtx);
+    while (true) {
+        workCv.wait(lock, [this] { return !workersRunning || !pendingJobs.empty(); });
+        if (!workersRunning) {
+            break;
+        }
+        std::shared_ptr<DetectionJob> job = pendingJobs.front();
+        pendingJobs.pop_front();
+        lock.unlock();
+
+        // Only this worker touches the job until it is marked done
+        auto start = std::chrono::high_resolution_clock::now();
+        job->failed = !detectFaces(net, *job);
+        job->doneTime = std::chrono::high_resolution_clock::now();
+        job->detectionTime = std::chrono::duration<double, std::milli>(job->doneTime - start).count();
+
+        lock.lock();
+        job->done = true;
+        detectionsInFlight--;
+        slotCv.notify_all();
+        flushLocked();
+    }
+}
+
+void FaceDetectionComponent::flushLocked() {
+    while (!inFlight.empty() && inFlight.front()->done) {
+        std::shared_ptr<DetectionJob> job = inFlight.front();
+        inFlight.pop_front();
+        if (job->detect) {
+            double reorderWait = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - job->doneTime).count();
+            totalReorderWait += reorderWait;
+            maxReorderWait = std::max(maxReorderWait, reorderWait);
+            applyDetection(*job);
+            if (job->failed) {
+                continue; // Dropped, as a failed detection always was
             }
-            auto start = std::chrono::high_resolution_clock::now();
-            detectFaces(frame);
-            auto end = std::chrono::high_resolution_clock::now();
-            double detectionTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-            updatePerformanceMetrics(detectionTime);
         }
+        outputFrames++;
+        outputQueue.push(std::move(job->packet)); // Pass the complete frame with the bounding box
     }
 }
 
-// Function to start the YOLO face detection and send the face with max confidence
-void FaceDetectionComponent::detectFaces(cv::Mat& frame) {
+void FaceDetectionComponent::applyDetection(DetectionJob& job) {
+    FramePacket& packet = job.packet;
+    updatePerformanceMetrics(std::floor(job.detectionTime));
+    detectedFrames++;
+    bool windowed = job.inputSize == FACE_SEARCH_INPUT_SIZE;
+    if (windowed) {
+        windowedDetections++;
+        totalWindowedTime += job.detectionTime;
+    } else {
+        fullFrameDetections++;
+        totalFullFrameTime += job.detectionTime;
+    }
+    if (job.failed) {
+        tracker.clear();
+        return;
+    }
+    totalWorkerTime += job.detectionTime;
+    totalDecodeTime += job.decodeTime;
+    maxDecodeTime = std::max(maxDecodeTime, job.decodeTime);
+    totalCandidates += job.candidates;
+    totalFacesKept += job.faces.size();
+
+    packet.faceSearched = true;
+    // The threshold may have been raised since the worker filtered with it
+    if (!job.faces.empty() && job.faces[0].confidence > fdt.load() / 100.0f) {
+        // Keep the box inside the frame so later stages can crop it directly
+        packet.roi = job.faces[0].box & cv::Rect(0, 0, packet.frame.cols, packet.frame.rows);
+        packet.hasRoi = packet.roi.area() > 0;
+    }
+    if (packet.hasRoi) {
+        tracker.reset(packet.frame, packet.roi);
+        lastFace = packet.roi;
+        hasLastFace = true;
+        searchMisses = 0;
+        if (job.tracked) {
+            recordDrift(job.trackedRoi, packet.roi);
+        }
+    } else {
+        tracker.clear();
+        if (windowed) {
+            // The face may have moved out of the window, keep looking there until the fallback
+            windowMisses++;
+            searchMisses++;
+        } else {
+            hasLastFace = false;
+            searchMisses = 0;
+        }
+    }
+    packet.faceDetectionEnd = FramePacket::Clock::now();
+}
+
+// Function to start the YOLO face detection and decode the faces above the threshold
+bool FaceDetectionComponent::detectFaces(cv::dnn::Net& net, DetectionJob& job) {
     cv::Mat blob;
     try {
-        cv::dnn::blobFromImage(frame, blob, 1 / 255.0, cv::Size(320, 320), cv::Scalar(0, 0, 0), true, false);
+        cv::dnn::blobFromImage(job.packet.frame(job.area), blob, 1 / 255.0, cv::Size(job.inputSize, job.inputSize),
+                               cv::Scalar(0, 0, 0), true, false);
         net.setInput(blob);
         std::vector<cv::Mat> outs;
         net.forward(outs, net.getUnconnectedOutLayersNames());
 
-        float maxConf = 0;
-        cv::Rect bestFaceRect;
-        for (const auto& out : outs) {
-            for (int i = 0; i < out.rows; ++i) {
-                const float* detection = out.ptr<float>(i);
-                float confidence = detection[4];
-                if (confidence > maxConf) {
-                    maxConf = confidence;
-                    bestFaceRect = getFaceRect(detection, frame);
-                }
-            }
-        }
-
-        if (maxConf > static_cast<float>(fdt) / 100.0f) {
-            cv::rectangle(frame, bestFaceRect, cv::Scalar(0, 255, 0), 2);
-            faceRectQueue.push(bestFaceRect); // Push the bounding box coordinates
-        }
-        outputQueue.push(frame); // Pass the complete frame with the bounding box
+        auto decodeStart = std::chrono::high_resolution_clock::now();
+        job.candidates = decodeFaces(outs, job.area, fdt.load() / 100.0f, job.faces);
+        job.decodeTime = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - decodeStart).count();
+        return true;
     } catch (const cv::Exception& e) {
         std::cerr << "OpenCV error: " << e.what() << std::endl;
+        return false;
     }
 }
 
-// Helper function to calculate the rectangle of the face from detection data
-cv::Rect FaceDetectionComponent::getFaceRect(const float* detection, const cv::Mat& frame) {
-    int centerX = static_cast<int>(detection[0] * frame.cols);
-    int centerY = static_cast<int>(detection[1] * frame.rows);
-    int width = static_cast<int>(detection[2] * frame.cols);
-    int height = static_cast<int>(detection[3] * frame.rows);
-    int left = centerX - width / 2;
-    int top = centerY - height / 2;
+void FaceDetectionComponent::recordDrift(const cv::Rect& tracked, const cv::Rect& detected) {
+    double drift = std::hypot((tracked.x + tracked.width / 2.0) - (detected.x + detected.width / 2.0),
+                              (tracked.y + tracked.height / 2.0) - (detected.y + detected.height / 2.0));
+    double overlap = (tracked & detected).area();
+    double iou = overlap / (tracked.area() + detected.area() - overlap);
 
-    return cv::Rect(left, top, width, height);
+    driftSamples++;
+    totalDrift += drift;
+    maxDrift = std::max(maxDrift, drift);
+    totalDriftIoU += iou;
+}
+
+// The window around the last face while it keeps being found there, the full frame otherwise
+cv::Rect FaceDetectionComponent::nextSearchArea(const cv::Mat& frame, int& inputSize) const {
+    cv::Rect full(0, 0, frame.cols, frame.rows);
+    inputSize = FACE_DETECT_INPUT_SIZE;
+    int maxMisses = maxSearchMisses.load();
+    if (maxMisses <= 0 || !hasLastFace || searchMisses >= maxMisses) {
+        return full;
+    }
+    int marginX = static_cast<int>(lastFace.width * FACE_SEARCH_MARGIN);
+    int marginY = static_cast<int>(lastFace.height * FACE_SEARCH_MARGIN);
+    cv::Rect window = cv::Rect(lastFace.x - marginX, lastFace.y - marginY,
+                               lastFace.width + 2 * marginX, lastFace.height + 2 * marginY) & full;
+    // A window this large saves nothing over the full frame
+    if (window.area() * 4 > full.area()) {
+        return full;
+    }
+    inputSize = FACE_SEARCH_INPUT_SIZE;
+    return window;
 }
 
 void FaceDetectionComponent::updatePerformanceMetrics(double detectionTime) {
@@ -142,7 +459,26 @@ void FaceDetectionComponent::setFDT(int fdt) {
     std::cout << "FDT CHANGED SUCCESSFULLY" << std::endl;
 }
 
+void FaceDetectionComponent::setTracking(int detectEvery, int minConfidence) {
+    skipRate.store(std::max(detectEvery, 1));
+    trackConfidence.store(minConfidence);
+    std::cout << "Face detection every " << skipRate.load() << " frames, re-detect below "
+              << minConfidence << "% tracking confidence" << std::endl;
+}
+
+void FaceDetectionComponent::setSearchWindow(int maxMisses) {
+    maxSearchMisses.store(std::max(maxMisses, 0));
+    std::cout << "Face search window " << (maxMisses > 0 ? "on, full-frame scan after " + std::to_string(maxMisses) + " misses" : "off")
+              << std::endl;
+}
+
+void FaceDetectionComponent::setWorkers(int count) {
+    workerCount = std::max(count, 1);
+}
+
 void FaceDetectionComponent::logPerformanceMetrics() {
+    std::lock_guard<std::mutex> lock(pipelineMtx);
+
     // Ensure the directory exists
     fs::path dir("benchmarklogs");
     if (!fs::exists(dir)) {
@@ -166,19 +502,77 @@ void FaceDetectionComponent::logPerformanceMetrics() {
         minDetectionTime = 0;
     }
     logFile << "Face Detection Metrics:\n";
+    logFile << "Backend: " << activeBackend << " (requested " << backendName << "), Measured Latency: "
+            << activeBackendLatency << " ms\n";
     logFile << "Max Detection Time: " << maxDetectionTime << " ms\n";
     logFile << "Min Detection Time: " << minDetectionTime << " ms\n";
     logFile << "Average Detection Time: " << averageDetectionTime << " ms\n";
-    resetPerformanceMetrics();
+    logFile << "Detect Every: " << skipRate.load() << " frames, Min Tracking Confidence: " << trackConfidence.load() << "%\n";
+    logFile << "Detected Frames: " << detectedFrames << ", Tracked Frames: " << trackedFrames << "\n";
+    logFile << "Detect/Track Ratio: " << (trackedFrames > 0 ? static_cast<double>(detectedFrames) / trackedFrames : 0) << "\n";
+    logFile << "Low Confidence Re-detections: " << lowConfidenceDetections << "\n";
+    logFile << "Average Tracking Time: " << (trackingRuns > 0 ? totalTrackingTime / trackingRuns : 0) << " ms\n";
+    logFile << "Max Tracking Time: " << maxTrackingTime << " ms\n";
+    logFile << "Average Drift at Re-detection: " << (driftSamples > 0 ? totalDrift / driftSamples : 0) << " px\n";
+    logFile << "Max Drift at Re-detection: " << maxDrift << " px\n";
+    logFile << "Average IoU at Re-detection: " << (driftSamples > 0 ? totalDriftIoU / driftSamples : 0) << "\n";
+    logFile << "Search Window Max Misses: " << maxSearchMisses.load() << "\n";
+    logFile << "Windowed Detections: " << windowedDetections << ", Average Time: "
+            << (windowedDetections > 0 ? totalWindowedTime / windowedDetections : 0) << " ms\n";
+    logFile << "Full-Frame Detections: " << fullFrameDetections << ", Average Time: "
+            << (fullFrameDetections > 0 ? totalFullFrameTime / fullFrameDetections : 0) << " ms\n";
+    logFile << "Search Window Misses: " << windowMisses << "\n";
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - lastTime).count();
+    logFile << "Detection Workers: " << nets.size() << ", Max Detections In Flight: " << maxDetectionsInFlight << "\n";
+    logFile << "Output Frames: " << outputFrames << ", Output Rate: " << (seconds > 0 ? outputFrames / seconds : 0) << " fps\n";
+    logFile << "Average Reorder Wait: " << (detectedFrames > 0 ? totalReorderWait / detectedFrames : 0) << " ms\n";
+    logFile << "Max Reorder Wait: " << maxReorderWait << " ms\n";
+    int decodedFrames = fullFrameDetections + windowedDetections;
+    logFile << "Average Decode Time: " << (decodedFrames > 0 ? totalDecodeTime / decodedFrames : 0) << " ms ("
+            << (totalWorkerTime > 0 ? 100.0 * totalDecodeTime / totalWorkerTime : 0) << "% of detection time)\n";
+    logFile << "Max Decode Time: " << maxDecodeTime << " ms\n";
+    logFile << "Average Boxes Before/After NMS: " << (decodedFrames > 0 ? static_cast<double>(totalCandidates) / decodedFrames : 0)
+            << " / " << (decodedFrames > 0 ? static_cast<double>(totalFacesKept) / decodedFrames : 0) << "\n";
+    resetPerformanceMetricsLocked();
     logFile << "<<------------------------------------------------------------------->>\n";
     logFile.close();
 }
 
 void FaceDetectionComponent::resetPerformanceMetrics() {
+    std::lock_guard<std::mutex> lock(pipelineMtx);
+    resetPerformanceMetricsLocked();
+}
+
+void FaceDetectionComponent::resetPerformanceMetricsLocked() {
     totalDetectionTime = 0.0;
     totalFramesProcessed = 0;
     maxDetectionTime = 0.0;
     minDetectionTime = std::numeric_limits<double>::max();
+    detectedFrames = 0;
+    trackedFrames = 0;
+    lowConfidenceDetections = 0;
+    trackingRuns = 0;
+    totalTrackingTime = 0.0;
+    maxTrackingTime = 0.0;
+    driftSamples = 0;
+    totalDrift = 0.0;
+    maxDrift = 0.0;
+    totalDriftIoU = 0.0;
+    windowedDetections = 0;
+    fullFrameDetections = 0;
+    windowMisses = 0;
+    totalWindowedTime = 0.0;
+    totalFullFrameTime = 0.0;
+    outputFrames = 0;
+    maxDetectionsInFlight = 0;
+    totalReorderWait = 0.0;
+    maxReorderWait = 0.0;
+    totalDecodeTime = 0.0;
+    maxDecodeTime = 0.0;
+    totalWorkerTime = 0.0;
+    totalCandidates = 0;
+    totalFacesKept = 0;
+    lastTime = std::chrono::high_resolution_clock::now();
 }
 
 
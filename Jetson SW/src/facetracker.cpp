@@ -0,0 +1,58 @@
+#include "facetracker.h"
+#include <algorithm>
+
+// Grayscale copy of 'area' of 'frame', resized by 'scale'
+static cv::Mat grayScaled(const cv::Mat& frame, const cv::Rect& area, double scale) {
+    cv::Mat gray;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame(area), gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = frame(area);
+    }
+    if (scale < 1.0) {
+        cv::Mat resized;
+        cv::resize(gray, resized, cv::Size(), scale, scale, cv::INTER_AREA);
+        return resized;
+    }
+    return gray.clone();
+}
+
+void FaceTracker::reset(const cv::Mat& frame, const cv::Rect& roi) {
+    cv::Rect inside = roi & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (inside.width < 8 || inside.height < 8) {
+        hasTarget = false;
+        return;
+    }
+    scale = std::min(1.0, static_cast<double>(FACE_TRACK_TEMPLATE_SIZE) / std::max(inside.width, inside.height));
+    faceTemplate = grayScaled(frame, inside, scale);
+    lastRoi = inside;
+    hasTarget = true;
+}
+
+bool FaceTracker::track(const cv::Mat& frame, cv::Rect& roi, double& confidence) {
+    if (!hasTarget) {
+        return false;
+    }
+    int marginX = static_cast<int>(lastRoi.width * FACE_TRACK_SEARCH_MARGIN);
+    int marginY = static_cast<int>(lastRoi.height * FACE_TRACK_SEARCH_MARGIN);
+    cv::Rect search(lastRoi.x - marginX, lastRoi.y - marginY,
+                    lastRoi.width + 2 * marginX, lastRoi.height + 2 * marginY);
+    search &= cv::Rect(0, 0, frame.cols, frame.rows);
+
+    cv::Mat area = grayScaled(frame, search, scale);
+    if (area.cols < faceTemplate.cols || area.rows < faceTemplate.rows) {
+        return false; // Face left the frame
+    }
+
+    cv::Mat scores;
+    cv::matchTemplate(area, faceTemplate, scores, cv::TM_CCOEFF_NORMED);
+    double maxScore;
+    cv::Point best;
+    cv::minMaxLoc(scores, nullptr, &maxScore, nullptr, &best);
+
+    lastRoi.x = search.x + static_cast<int>(best.x / scale);
+    lastRoi.y = search.y + static_cast<int>(best.y / scale);
+    roi = lastRoi & cv::Rect(0, 0, frame.cols, frame.rows);
+    confidence = maxScore;
+    return roi.area() > 0;
+}
@@ -74,7 +74,7 @@ void FaultManager::faultfind()
     std::string fault;
     while (running)
     {
-        if (faultsQueue.tryPop(fault))
+        if (faultsQueue.waitPopFor(fault, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS)))
         {
             std::cout << "Received fault in the fault manager "<< fault << std::endl;
             this->faulthandling(fault);
@@ -193,6 +193,14 @@ void FaultManager::faulthandling(const std::string &fault)
         commandsQueue.push(command);
     }
 
+    /**************************** DMS manager faults *********************************/
+
+    //Command with a malformed numeric value, it was ignored
+    else if (fault.find("Command_fault") != std::string::npos)
+    {
+        std::cout << "Malformed command ignored" << std::endl;
+    }
+
     /**************************** Vehicle state manager fault *************************/
 
     else if (fault.find("Velocity_fault") != std::string::npos)
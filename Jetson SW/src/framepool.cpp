@@ -0,0 +1,164 @@
+#include "framepool.h"
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace fs = boost::filesystem;
+namespace pt = boost::posix_time;
+namespace gr = boost::gregorian;
+
+FramePool* FramePool::instance = nullptr;
+std::mutex FramePool::instanceMtx;
+
+FramePool::FramePool() : metricsStart(std::chrono::steady_clock::now()) {}
+
+FramePool* FramePool::getInstance() {
+    std::lock_guard<std::mutex> lock(instanceMtx);
+    if (!instance) {
+        instance = new FramePool();
+    }
+    return instance;
+}
+
+void FramePool::reserve(size_t blockBytes, size_t blockCount) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (blockBytes == blockSize && blockCount == this->blockCount) {
+        return;
+    }
+    for (uchar* block : freeBlocks) {
+        cv::fastFree(block);
+    }
+    freeBlocks.clear();
+    generation++;
+    blockSize = blockBytes;
+    this->blockCount = blockCount;
+    for (size_t i = 0; i < blockCount; ++i) {
+        freeBlocks.push_back(static_cast<uchar*>(cv::fastMalloc(blockBytes)));
+    }
+    std::cout << "Frame pool reserved " << blockCount << " buffers of " << blockBytes << " bytes" << std::endl;
+}
+
+size_t FramePool::getBlockSize() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return blockSize;
+}
+
+// Same layout rules as OpenCV's default allocator, only the storage comes from the pool
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                                  FramePoolAccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data0 && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->size = total;
+    if (data0) {
+        u->data = u->origdata = static_cast<uchar*>(data0);
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    uchar* data = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        allocationCount++;
+        if (total <= blockSize && !freeBlocks.empty()) {
+            data = freeBlocks.back();
+            freeBlocks.pop_back();
+            u->userdata = const_cast<FramePool*>(this); // Marks a pooled block
+            u->allocatorFlags_ = generation;
+            pooledCount++;
+            inUse++;
+            peakInUse = std::max(peakInUse, inUse);
+        } else {
+            exhaustedCount++;
+        }
+    }
+    if (!data) {
+        data = static_cast<uchar*>(cv::fastMalloc(total));
+    }
+    u->data = u->origdata = data;
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData* u, FramePoolAccessFlag /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    return u != nullptr;
+}
+
+// Called by OpenCV once the last Mat referencing the buffer is released
+void FramePool::deallocate(cv::UMatData* u) const {
+    if (!u) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        bool returned = false;
+        if (u->userdata == this) {
+            std::lock_guard<std::mutex> lock(mtx);
+            inUse--;
+            if (u->allocatorFlags_ == generation) {
+                freeBlocks.push_back(u->origdata);
+                returned = true;
+            }
+        }
+        if (!returned) {
+            cv::fastFree(u->origdata);
+        }
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+void FramePool::logPoolMetrics() {
+    // Ensure the directory exists
+    fs::path dir("benchmarklogs");
+    if (!fs::exists(dir)) {
+        fs::create_directory(dir);
+    }
+
+    // Get current time and format the filename
+    pt::ptime now = pt::second_clock::local_time();
+    std::ostringstream filename;
+    filename << dir.string() << "/benchmark_log_"
+             << gr::to_iso_extended_string(now.date()) << "_"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().hours() << "-"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().minutes()
+             << ".txt";
+
+    // Open the log file in append mode
+    std::ofstream logFile(filename.str(), std::ios::app);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - metricsStart).count();
+    logFile << "Frame Pool Metrics:\n";
+    logFile << "Buffers: " << blockCount << " x " << blockSize << " bytes\n";
+    logFile << "Allocations: " << allocationCount << "\n";
+    logFile << "Allocations per Second: " << (seconds > 0 ? allocationCount / seconds : 0) << "\n";
+    logFile << "Served from Pool: " << pooledCount << "\n";
+    logFile << "Pool Exhausted (heap fallback): " << exhaustedCount << "\n";
+    logFile << "Peak Buffers in Use: " << peakInUse << "\n";
+    logFile << "<<------------------------------------------------------------------->>\n";
+    logFile.close();
+
+    allocationCount = 0;
+    pooledCount = 0;
+    exhaustedCount = 0;
+    peakInUse = inUse;
+    metricsStart = end;
+}
@@ -55,7 +55,7 @@ void HeadPoseComponent::HeadPoseDetectionLoop() {
     bool isFirstFrame = true; // Flag to check if it's the first frame
 
     while (running) {
-        if (inputQueue.tryPop(frame)) {
+        if (inputQueue.waitPopFor(frame, std::chrono::milliseconds(QUEUE_WAIT_TIMEOUT_MS))) {
             cv::Mat croppedFace;
             // Assuming the face is detected and bounded by a rectangle
             cv::Rect faceRect = detectFaceRectangle(frame); // Implement this function to find the rectangle
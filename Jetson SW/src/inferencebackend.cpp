@@ -0,0 +1,120 @@
+#include "inferencebackend.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+// Size of a file in bytes, 0 if it can't be opened
+static size_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+bool IInferenceBackend::inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs) {
+    outputs.clear();
+    std::vector<float> output;
+    for (size_t i = 0; i < count; ++i) {
+        if (!infer(inputs + i * inputSize, output)) {
+            return false;
+        }
+        outputs.insert(outputs.end(), output.begin(), output.end());
+    }
+    return true;
+}
+
+CPUInferenceBackend::CPUInferenceBackend(const std::string& model, const std::string& weights,
+                                         cv::Size inputSize, int threads)
+    : inputSize(inputSize), threads(threads) {
+    try {
+        if (model.size() > 4 && model.compare(model.size() - 4, 4, ".cfg") == 0) {
+            net = cv::dnn::readNetFromDarknet(model, weights);
+            modelBytes = fileSize(model) + fileSize(weights);
+        } else {
+            net = cv::dnn::readNetFromONNX(model);
+            modelBytes = fileSize(model);
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "Failed to load CPU model " << model << ": " << e.what() << std::endl;
+        return;
+    }
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    if (threads > 0) {
+        cv::setNumThreads(threads);
+    }
+}
+
+bool CPUInferenceBackend::infer(const float* input, std::vector<float>& output) {
+    return inferBatch(input, 1, 3 * inputSize.area(), output);
+}
+
+bool CPUInferenceBackend::inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs) {
+    if (net.empty()) {
+        return false;
+    }
+    if (count > 1 && fixedBatch) {
+        return IInferenceBackend::inferBatch(inputs, count, inputSize, outputs);
+    }
+    try {
+        // Wrap the tensors as a N x 3 x H x W blob without copying them
+        const int dims[4] = {static_cast<int>(count), 3, this->inputSize.height, this->inputSize.width};
+        cv::Mat blob(4, dims, CV_32F, const_cast<float*>(inputs));
+        net.setInput(blob);
+        cv::Mat result = net.forward();
+        const float* values = result.ptr<float>();
+        outputs.assign(values, values + result.total());
+        return true;
+    } catch (const cv::Exception& e) {
+        if (count > 1) {
+            std::cerr << "CPU model takes no batch, running inputs one at a time: " << e.what() << std::endl;
+            fixedBatch = true;
+            return IInferenceBackend::inferBatch(inputs, count, inputSize, outputs);
+        }
+        std::cerr << "CPU inference failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::string CPUInferenceBackend::getName() const {
+    return "CPU (cv::dnn, " + (threads > 0 ? std::to_string(threads) : std::string("default")) + " threads)";
+}
+
+size_t CPUInferenceBackend::getResidentBytes() const {
+    // Weights plus one input blob
+    return modelBytes + 3 * inputSize.width * inputSize.height * sizeof(float);
+}
+
+MockInferenceBackend::MockInferenceBackend(size_t inputSize, size_t outputSize, int launchOverheadUs, int perInputUs)
+    : inputSize(inputSize), outputSize(outputSize), launchOverheadUs(launchOverheadUs), perInputUs(perInputUs) {}
+
+bool MockInferenceBackend::infer(const float* input, std::vector<float>& output) {
+    return inferBatch(input, 1, inputSize, output);
+}
+
+bool MockInferenceBackend::inferBatch(const float* inputs, size_t count, size_t inputSize, std::vector<float>& outputs) {
+    std::this_thread::sleep_for(std::chrono::microseconds(launchOverheadUs + perInputUs * static_cast<int>(count)));
+    outputs.resize(count * outputSize);
+    for (size_t i = 0; i < count; ++i) {
+        double sum = 0;
+        for (size_t j = 0; j < inputSize; ++j) {
+            sum += inputs[i * inputSize + j];
+        }
+        const float mean = inputSize > 0 ? static_cast<float>(sum / inputSize) : 0.0f;
+        std::fill(outputs.begin() + i * outputSize, outputs.begin() + (i + 1) * outputSize, mean);
+    }
+    return true;
+}
+
+std::string MockInferenceBackend::getName() const {
+    return "Mock (" + std::to_string(launchOverheadUs) + " us launch, " + std::to_string(perInputUs) + " us per input)";
+}
+
+std::string onnxPathForEngine(const std::string& enginePath) {
+    size_t dot = enginePath.find_last_of('.');
+    size_t slash = enginePath.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return enginePath + ".onnx";
+    }
+    return enginePath.substr(0, dot) + ".onnx";
+}
@@ -0,0 +1,86 @@
+#include "inferencesession.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+InferenceSession::InferenceSession(std::unique_ptr<ISessionBackend> backend, size_t inputSize, size_t outputSize)
+    : backend(std::move(backend)), inputSize(inputSize), outputSize(outputSize) {
+    deviceInput = this->backend->allocateDevice(inputSize * sizeof(float));
+    deviceOutput = this->backend->allocateDevice(outputSize * sizeof(float));
+    if (!deviceInput || !deviceOutput) {
+        std::cerr << "Failed to allocate inference session buffers" << std::endl;
+    }
+}
+
+InferenceSession::~InferenceSession() {
+    if (deviceInput) {
+        backend->freeDevice(deviceInput);
+    }
+    if (deviceOutput) {
+        backend->freeDevice(deviceOutput);
+    }
+}
+
+bool InferenceSession::run(const float* input, float* output) {
+    if (!deviceInput || !deviceOutput) {
+        return false;
+    }
+    void* bindings[] = {deviceInput, deviceOutput};
+    if (!backend->copyToDevice(deviceInput, input, inputSize * sizeof(float)) ||
+        !backend->execute(bindings) ||
+        !backend->copyToHost(output, deviceOutput, outputSize * sizeof(float))) {
+        std::cerr << "Inference session run failed" << std::endl;
+        return false;
+    }
+    runCount++;
+    return true;
+}
+
+MockSessionBackend::MockSessionBackend(size_t inputSize, size_t outputSize)
+    : inputSize(inputSize), outputSize(outputSize) {}
+
+void* MockSessionBackend::allocateDevice(size_t bytes) {
+    if (failAllocation) {
+        return nullptr;
+    }
+    allocationCount++;
+    return std::malloc(bytes);
+}
+
+void MockSessionBackend::freeDevice(void* buffer) {
+    std::free(buffer);
+}
+
+bool MockSessionBackend::copyToDevice(void* dst, const void* src, size_t bytes) {
+    if (failCopy) {
+        return false;
+    }
+    std::memcpy(dst, src, bytes);
+    return true;
+}
+
+bool MockSessionBackend::copyToHost(void* dst, const void* src, size_t bytes) {
+    if (failCopy) {
+        return false;
+    }
+    std::memcpy(dst, src, bytes);
+    return true;
+}
+
+bool MockSessionBackend::execute(void** bindings) {
+    if (failExecute) {
+        return false;
+    }
+    const float* input = static_cast<const float*>(bindings[0]);
+    float* output = static_cast<float*>(bindings[1]);
+    double sum = 0;
+    for (size_t i = 0; i < inputSize; ++i) {
+        sum += input[i];
+    }
+    const float mean = inputSize > 0 ? static_cast<float>(sum / inputSize) : 0.0f;
+    for (size_t i = 0; i < outputSize; ++i) {
+        output[i] = mean;
+    }
+    executeCount++;
+    return true;
+}
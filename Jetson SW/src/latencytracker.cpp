@@ -0,0 +1,141 @@
+#include "latencytracker.h"
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <iomanip>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+namespace fs = boost::filesystem;
+namespace pt = boost::posix_time;
+namespace gr = boost::gregorian;
+
+static const char* const stageNames[LatencyTracker::StageCount] = {
+    "Capture -> Face Detection",
+    "Face Detection",
+    "Face Detection -> AI",
+    "AI Inference",
+    "AI -> JPEG Encode",
+    "JPEG Encode",
+    "Socket Send",
+    "End-to-End"
+};
+
+LatencyHistogram::LatencyHistogram() : buckets(LATENCY_BUCKET_COUNT, 0), samples(0), maxMs(0), totalMs(0) {}
+
+void LatencyHistogram::add(double ms) {
+    if (ms < 0) {
+        ms = 0;
+    }
+    size_t bucket = static_cast<size_t>(ms / LATENCY_BUCKET_MS);
+    if (bucket >= buckets.size()) {
+        bucket = buckets.size() - 1;
+    }
+    buckets[bucket]++;
+    samples++;
+    totalMs += ms;
+    if (ms > maxMs) {
+        maxMs = ms;
+    }
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (samples == 0) {
+        return 0;
+    }
+    const size_t target = std::max<size_t>(1, static_cast<size_t>(std::ceil(p * samples)));
+    size_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min((i + 1) * LATENCY_BUCKET_MS, maxMs);
+        }
+    }
+    return maxMs;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    samples = 0;
+    maxMs = 0;
+    totalMs = 0;
+}
+
+LatencyTracker::LatencyTracker()
+    : liveDumpIntervalS(LATENCY_LIVE_DUMP_INTERVAL_S), lastDump(FramePacket::Clock::now()) {}
+
+void LatencyTracker::record(const FramePacket& packet) {
+    std::lock_guard<std::mutex> lock(mtx);
+    addStage(CaptureToFaceDetection, packet.captureTime, packet.faceDetectionStart);
+    addStage(FaceDetection, packet.faceDetectionStart, packet.faceDetectionEnd);
+    addStage(FaceDetectionToAI, packet.faceDetectionEnd, packet.aiStart);
+    addStage(AIInference, packet.aiStart, packet.aiEnd);
+    addStage(AIToEncode, packet.aiEnd, packet.encodeStart);
+    addStage(JpegEncode, packet.encodeStart, packet.encodeEnd);
+    addStage(SocketSend, packet.encodeEnd, packet.sendEnd);
+    addStage(EndToEnd, packet.captureTime, packet.sendEnd);
+
+    // Live dump, the histograms keep accumulating until logLatencyMetrics()
+    const FramePacket::Clock::time_point now = FramePacket::Clock::now();
+    if (liveDumpIntervalS > 0 && now - lastDump >= std::chrono::seconds(liveDumpIntervalS)) {
+        lastDump = now;
+        writeMetrics("Live Latency Metrics:");
+    }
+}
+
+void LatencyTracker::setLiveDumpInterval(int seconds) {
+    std::lock_guard<std::mutex> lock(mtx);
+    liveDumpIntervalS = seconds;
+    lastDump = FramePacket::Clock::now();
+}
+
+void LatencyTracker::logLatencyMetrics() {
+    std::lock_guard<std::mutex> lock(mtx);
+    writeMetrics("Latency Metrics:");
+    for (int i = 0; i < StageCount; ++i) {
+        histograms[i].reset();
+    }
+    lastDump = FramePacket::Clock::now();
+}
+
+void LatencyTracker::addStage(Stage stage, FramePacket::Clock::time_point start, FramePacket::Clock::time_point end) {
+    // Unset timestamps stay at the clock epoch: the stage did not run on this frame
+    if (start == FramePacket::Clock::time_point() || end == FramePacket::Clock::time_point()) {
+        return;
+    }
+    histograms[stage].add(std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+void LatencyTracker::writeMetrics(const std::string& title) const {
+    // Ensure the directory exists
+    fs::path dir("benchmarklogs");
+    if (!fs::exists(dir)) {
+        fs::create_directory(dir);
+    }
+
+    // Get current time and format the filename
+    pt::ptime now = pt::second_clock::local_time();
+    std::ostringstream filename;
+    filename << dir.string() << "/benchmark_log_"
+             << gr::to_iso_extended_string(now.date()) << "_"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().hours() << "-"
+             << std::setw(2) << std::setfill('0') << now.time_of_day().minutes()
+             << ".txt";
+
+    // Open the log file in append mode
+    std::ofstream logFile(filename.str(), std::ios::app);
+
+    logFile << title << "\n";
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram& histogram = histograms[i];
+        logFile << stageNames[i] << ": frames " << histogram.count()
+                << ", p50 " << histogram.percentile(0.50) << " ms"
+                << ", p90 " << histogram.percentile(0.90) << " ms"
+                << ", p99 " << histogram.percentile(0.99) << " ms"
+                << ", max " << histogram.max() << " ms"
+                << ", avg " << histogram.mean() << " ms\n";
+    }
+    logFile << "<<------------------------------------------------------------------->>\n";
+    logFile.close();
+}
@@ -1,16 +1,17 @@
 #include <opencv2/opencv.hpp>
 #include "threadsafequeue.h"
+#include "framepacket.h"
+#include "readings.h"
 #include "dmsmanager.h"
 #include <benchmark/benchmark.h>
 
 int main() {
 
     // Initialize thread-safe queues needed for each component
-    ThreadSafeQueue<cv::Mat> cameraQueue;
-    ThreadSafeQueue<cv::Mat> faceDetectionQueue; 
-    ThreadSafeQueue<cv::Rect> faceRectQueue;
-    ThreadSafeQueue<std::vector<std::vector<float>>> AIDetectionQueue;
-    ThreadSafeQueue<cv::Mat> framesQueue;
+    ThreadSafeQueue<FramePacket> cameraQueue;
+    ThreadSafeQueue<FramePacket> faceDetectionQueue;
+    ThreadSafeQueue<Readings> AIDetectionQueue;
+    ThreadSafeQueue<FramePacket> framesQueue;
     ThreadSafeQueue<cv::Mat> tcpOutputQueue;
     ThreadSafeQueue<std::string> commandsQueue;
     ThreadSafeQueue<std::string> faultsQueue;
@@ -18,7 +19,7 @@ int main() {
     int tcpPort = 12345;  // Define the TCP port for the server
 
     // Initialize the DMSManager with all necessary queues and the TCP port
-    DMSManager dmsManager(cameraQueue, faceDetectionQueue, faceRectQueue,
+    DMSManager dmsManager(cameraQueue, faceDetectionQueue,
                           AIDetectionQueue,framesQueue,
 			  tcpOutputQueue, tcpPort,
                           commandsQueue, faultsQueue);
@@ -36,13 +37,13 @@ int main() {
     }
 
     // Main loop (The display code is commented out; uncomment if needed)
-    cv::Mat cameraFrame;
+    FramePacket cameraPacket;
     while (true) {
 
         // Uncomment the following block to show frames from different components during development , if need to show frames on jetson
 
-        // if (cameraQueue.tryPop(cameraFrame) && !cameraFrame.empty()) {
-        //    cv::imshow("Camera Frame", cameraFrame);
+        // if (cameraQueue.tryPop(cameraPacket) && !cameraPacket.frame.empty()) {
+        //    cv::imshow("Camera Frame", cameraPacket.frame);
         // }
 
         if (cv::waitKey(1) == 27) break;  // Exit on ESC key
@@ -0,0 +1,36 @@
+#include "mappedfile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        std::cerr << "Error reading size of file: " << path << std::endl;
+        close(fd);
+        return;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file referenced
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping file: " << path << std::endl;
+        return;
+    }
+    data = mapping;
+    size = static_cast<size_t>(info.st_size);
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, size, MADV_WILLNEED);
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        munmap(data, size);
+    }
+}
@@ -0,0 +1,76 @@
+#include "modelcache.h"
+
+ModelCache::ModelCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+std::shared_ptr<IInferenceBackend> ModelCache::getOrLoad(const std::string& key, const Loader& loader) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            hits++;
+            return it->second->model;
+        }
+    }
+
+    std::shared_ptr<IInferenceBackend> model = loader();
+    if (!model) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    misses++;
+    // Another thread may have loaded the same key meanwhile, keep the first one
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->model;
+    }
+    Entry entry = {key, model, model->getResidentBytes()};
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    resident += entry.bytes;
+    evictLocked();
+    return model;
+}
+
+bool ModelCache::contains(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return index.find(key) != index.end();
+}
+
+void ModelCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mtx);
+    budget = budgetBytes;
+    evictLocked();
+}
+
+size_t ModelCache::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return resident;
+}
+
+void ModelCache::logCacheMetrics(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mtx);
+    out << "Model Cache Budget: " << static_cast<double>(budget) / (1024 * 1024) << " MB\n";
+    out << "Model Cache Resident: " << static_cast<double>(resident) / (1024 * 1024) << " MB in "
+        << entries.size() << " models\n";
+    for (const auto& entry : entries) {
+        out << "  " << entry.key << ": " << static_cast<double>(entry.bytes) / (1024 * 1024) << " MB\n";
+    }
+    out << "Model Cache Hits: " << hits << ", Misses: " << misses << ", Evictions: " << evictions << "\n";
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+void ModelCache::evictLocked() {
+    auto it = entries.end();
+    while (resident > budget && it != entries.begin()) {
+        --it;
+        resident -= it->bytes;
+        index.erase(it->key);
+        it = entries.erase(it);
+        evictions++;
+    }
+}
@@ -0,0 +1,160 @@
+#include "preprocess.h"
+#include <opencv2/core/hal/intrin.hpp>
+
+// ImageNet normalization in RGB order, matches how the engines were trained
+static const float meanRGB[3] = {0.485f, 0.456f, 0.406f};
+static const float stdRGB[3] = {0.229f, 0.224f, 0.225f};
+
+// Bring gray or BGRA input to 8-bit BGR, the layout the fused pass reads
+static const cv::Mat& toBGR(const cv::Mat& image, cv::Mat& converted) {
+    if (image.type() == CV_8UC1) {
+        cv::cvtColor(image, converted, cv::COLOR_GRAY2BGR);
+        return converted;
+    }
+    if (image.type() == CV_8UC4) {
+        cv::cvtColor(image, converted, cv::COLOR_BGRA2BGR);
+        return converted;
+    }
+    CV_Assert(image.type() == CV_8UC3);
+    return image;
+}
+
+#if CV_SIMD128
+// Widen 16 pixels of one channel to float and apply pixel * scale + offset, four per vector
+static inline void normalizeLanes(const cv::v_uint8x16& pixels, const cv::v_float32x4& scale,
+                                  const cv::v_float32x4& offset, cv::v_float32x4 out[4]) {
+    cv::v_uint16x8 low, high;
+    cv::v_expand(pixels, low, high);
+    cv::v_uint32x4 p0, p1, p2, p3;
+    cv::v_expand(low, p0, p1);
+    cv::v_expand(high, p2, p3);
+    out[0] = cv::v_muladd(cv::v_cvt_f32(cv::v_reinterpret_as_s32(p0)), scale, offset);
+    out[1] = cv::v_muladd(cv::v_cvt_f32(cv::v_reinterpret_as_s32(p1)), scale, offset);
+    out[2] = cv::v_muladd(cv::v_cvt_f32(cv::v_reinterpret_as_s32(p2)), scale, offset);
+    out[3] = cv::v_muladd(cv::v_cvt_f32(cv::v_reinterpret_as_s32(p3)), scale, offset);
+}
+
+// Normalize 16 pixels of one channel and store them
+static inline void storeNormalized(const cv::v_uint8x16& pixels, const cv::v_float32x4& scale,
+                                   const cv::v_float32x4& offset, float* dst) {
+    cv::v_float32x4 values[4];
+    normalizeLanes(pixels, scale, offset, values);
+    for (int k = 0; k < 4; ++k) {
+        cv::v_store(dst + 4 * k, values[k]);
+    }
+}
+#endif
+
+void preprocessToCHW(const cv::Mat& image, cv::Size size, float* dst) {
+    // Per-thread scratch, reused across calls once it has the right size
+    static thread_local cv::Mat converted;
+    static thread_local cv::Mat resized;
+    cv::resize(toBGR(image, converted), resized, size);
+
+    // (pixel / 255 - mean) / std folded into pixel * scale + offset
+    float scale[3], offset[3];
+    for (int c = 0; c < 3; ++c) {
+        scale[c] = 1.0f / (255.0f * stdRGB[c]);
+        offset[c] = -meanRGB[c] / stdRGB[c];
+    }
+
+    const int planeSize = size.area();
+    float* dstR = dst;
+    float* dstG = dst + planeSize;
+    float* dstB = dst + 2 * planeSize;
+
+#if CV_SIMD128
+    const cv::v_float32x4 scaleR = cv::v_setall_f32(scale[0]), offsetR = cv::v_setall_f32(offset[0]);
+    const cv::v_float32x4 scaleG = cv::v_setall_f32(scale[1]), offsetG = cv::v_setall_f32(offset[1]);
+    const cv::v_float32x4 scaleB = cv::v_setall_f32(scale[2]), offsetB = cv::v_setall_f32(offset[2]);
+#endif
+
+    for (int y = 0; y < resized.rows; ++y) {
+        const uchar* src = resized.ptr<uchar>(y);
+        const int rowStart = y * resized.cols;
+        int x = 0;
+#if CV_SIMD128
+        for (; x <= resized.cols - 16; x += 16) {
+            cv::v_uint8x16 b, g, r;
+            cv::v_load_deinterleave(src + 3 * x, b, g, r);
+            storeNormalized(r, scaleR, offsetR, dstR + rowStart + x);
+            storeNormalized(g, scaleG, offsetG, dstG + rowStart + x);
+            storeNormalized(b, scaleB, offsetB, dstB + rowStart + x);
+        }
+#endif
+        for (; x < resized.cols; ++x) {
+            dstR[rowStart + x] = src[3 * x + 2] * scale[0] + offset[0];
+            dstG[rowStart + x] = src[3 * x + 1] * scale[1] + offset[1];
+            dstB[rowStart + x] = src[3 * x] * scale[2] + offset[2];
+        }
+    }
+}
+
+void normalizeToRGB(const cv::Mat& image, cv::Mat& dst) {
+    static thread_local cv::Mat converted;
+    const cv::Mat& bgr = toBGR(image, converted);
+    dst.create(bgr.size(), CV_32FC3);
+
+    float scale[3], offset[3];
+    for (int c = 0; c < 3; ++c) {
+        scale[c] = 1.0f / (255.0f * stdRGB[c]);
+        offset[c] = -meanRGB[c] / stdRGB[c];
+    }
+#if CV_SIMD128
+    const cv::v_float32x4 scaleR = cv::v_setall_f32(scale[0]), offsetR = cv::v_setall_f32(offset[0]);
+    const cv::v_float32x4 scaleG = cv::v_setall_f32(scale[1]), offsetG = cv::v_setall_f32(offset[1]);
+    const cv::v_float32x4 scaleB = cv::v_setall_f32(scale[2]), offsetB = cv::v_setall_f32(offset[2]);
+#endif
+
+    for (int y = 0; y < bgr.rows; ++y) {
+        const uchar* src = bgr.ptr<uchar>(y);
+        float* out = dst.ptr<float>(y);
+        int x = 0;
+#if CV_SIMD128
+        // 16 pixels per step, normalized one channel at a time and stored back interleaved as RGB
+        for (; x <= bgr.cols - 16; x += 16) {
+            cv::v_uint8x16 b, g, r;
+            cv::v_load_deinterleave(src + 3 * x, b, g, r);
+            cv::v_float32x4 red[4], green[4], blue[4];
+            normalizeLanes(r, scaleR, offsetR, red);
+            normalizeLanes(g, scaleG, offsetG, green);
+            normalizeLanes(b, scaleB, offsetB, blue);
+            for (int k = 0; k < 4; ++k) {
+                cv::v_store_interleave(out + 3 * (x + 4 * k), red[k], green[k], blue[k]);
+            }
+        }
+#endif
+        for (; x < bgr.cols; ++x) {
+            out[3 * x] = src[3 * x + 2] * scale[0] + offset[0];
+            out[3 * x + 1] = src[3 * x + 1] * scale[1] + offset[1];
+            out[3 * x + 2] = src[3 * x] * scale[2] + offset[2];
+        }
+    }
+}
+
+void resizeToCHW(const cv::Mat& normalized, cv::Size size, float* dst) {
+    CV_Assert(normalized.type() == CV_32FC3);
+    static thread_local cv::Mat resized;
+    cv::resize(normalized, resized, size);
+
+    // The planes wrap dst, so split writes the tensor in place
+    const int planeSize = size.area();
+    cv::Mat planes[3] = {cv::Mat(size, CV_32F, dst), cv::Mat(size, CV_32F, dst + planeSize),
+                         cv::Mat(size, CV_32F, dst + 2 * planeSize)};
+    cv::split(resized, planes);
+}
+
+void preprocessToCHWReference(const cv::Mat& image, cv::Size size, float* dst) {
+    cv::Mat converted, resized;
+    cv::resize(toBGR(image, converted), resized, size);
+    const int planeSize = size.area();
+    for (int y = 0; y < resized.rows; ++y) {
+        for (int x = 0; x < resized.cols; ++x) {
+            const cv::Vec3b& pixel = resized.at<cv::Vec3b>(y, x);
+            for (int c = 0; c < 3; ++c) {
+                // Channel c of the RGB output is channel 2 - c of the BGR input
+                dst[c * planeSize + y * resized.cols + x] = (pixel[2 - c] / 255.0f - meanRGB[c]) / stdRGB[c];
+            }
+        }
+    }
+}
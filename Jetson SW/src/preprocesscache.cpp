@@ -0,0 +1,56 @@
+#include "preprocesscache.h"
+#include <algorithm>
+
+PreprocessCache::PreprocessCache() : entries(PREPROCESS_CACHE_SIZE) {}
+
+std::shared_ptr<const PreprocessedFace> PreprocessCache::lookup(uint64_t frameId, const cv::Rect& roi, const cv::Mat& crop) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& entry : entries) {
+        if (entry && entry->frameId == frameId && entry->roi == roi) {
+            hits++;
+            return entry;
+        }
+    }
+    misses++;
+
+    // Reuse the oldest slot's buffers unless a consumer still holds that entry
+    std::shared_ptr<PreprocessedFace>& slot = entries[next];
+    next = (next + 1) % entries.size();
+    if (!slot || slot.use_count() > 1) {
+        slot = std::make_shared<PreprocessedFace>();
+    }
+    slot->frameId = frameId;
+    slot->roi = roi;
+    convert(crop, *slot);
+    return slot;
+}
+
+size_t PreprocessCache::getHits() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return hits;
+}
+
+size_t PreprocessCache::getMisses() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return misses;
+}
+
+void PreprocessCache::resetMetrics() {
+    std::lock_guard<std::mutex> lock(mtx);
+    hits = 0;
+    misses = 0;
+}
+
+void PreprocessCache::convert(const cv::Mat& crop, PreprocessedFace& entry) {
+    const cv::Size size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+    entry.headPose.resize(3 * size.area());
+    entry.eyeGaze.resize(3 * size.area());
+
+    // One conversion and normalization of the crop at its own size. Each input is then resized
+    // once from it, as the models were trained, so neither picks up a second resampling
+    static thread_local cv::Mat normalized;
+    normalizeToRGB(crop, normalized);
+    resizeToCHW(normalized, size, entry.headPose.data());
+    int eyeGazeRows = std::max(1, static_cast<int>(crop.rows * EYE_GAZE_CROP_RATIO));
+    resizeToCHW(normalized.rowRange(0, eyeGazeRows), size, entry.eyeGaze.data());
+}
@@ -0,0 +1,178 @@
+#include "resourcesampler.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+ResourceSampler::ResourceSampler(DeviceMemoryProbe deviceProbe)
+    : slots(new Slot[RESOURCE_SAMPLE_RING_SIZE]), deviceProbe(deviceProbe) {}
+
+ResourceSampler::~ResourceSampler() {
+    stop();
+}
+
+void ResourceSampler::start() {
+    std::lock_guard<std::mutex> lock(threadMtx);
+    if (samplerThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> waitLock(waitMtx);
+        running = true;
+    }
+    samplerThread = std::thread(&ResourceSampler::samplerLoop, this);
+}
+
+void ResourceSampler::stop() {
+    std::lock_guard<std::mutex> lock(threadMtx);
+    {
+        std::lock_guard<std::mutex> waitLock(waitMtx);
+        running = false;
+    }
+    wakeCv.notify_all();
+    if (samplerThread.joinable()) {
+        samplerThread.join();
+    }
+}
+
+void ResourceSampler::setInterval(int milliseconds) {
+    intervalMs.store(std::max(milliseconds, 1));
+}
+
+void ResourceSampler::samplerLoop() {
+    std::unique_lock<std::mutex> lock(waitMtx);
+    while (running) {
+        lock.unlock();
+        takeSample();
+        lock.lock();
+        wakeCv.wait_for(lock, std::chrono::milliseconds(intervalMs.load()), [this] { return !running; });
+    }
+}
+
+void ResourceSampler::takeSample() {
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0, resident = 0;
+    statm >> size >> resident;
+    statm.close();
+
+    // Minor faults are the 10th field of /proc/self/stat
+    std::ifstream stat("/proc/self/stat");
+    std::string dummy;
+    size_t minorFaults = 0;
+    for (int i = 0; i < 9; ++i) stat >> dummy;
+    stat >> minorFaults;
+    stat.close();
+
+    std::ifstream procStat("/proc/stat");
+    std::string line, cpu;
+    std::getline(procStat, line);
+    procStat.close();
+    std::istringstream ss(line);
+    long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    ss >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+    long idleTime = idle + iowait;
+    long totalTime = user + nice + system + idle + iowait + irq + softirq + steal;
+    double cpuPercent = 0.0;
+    if (previousTotal > 0 && totalTime > previousTotal) {
+        long totalDiff = totalTime - previousTotal;
+        long idleDiff = idleTime - previousIdle;
+        cpuPercent = 100.0 * (totalDiff - idleDiff) / totalDiff;
+    }
+    previousIdle = idleTime;
+    previousTotal = totalTime;
+
+    size_t deviceUsed = deviceProbe ? deviceProbe() : 0;
+
+    // Publish: odd sequence while writing, even again once the slot is consistent
+    uint64_t index = written.load(std::memory_order_relaxed);
+    Slot& slot = slots[index & (RESOURCE_SAMPLE_RING_SIZE - 1)];
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.index.store(index, std::memory_order_relaxed);
+    slot.time.store(start.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.rssBytes.store(resident * sysconf(_SC_PAGESIZE), std::memory_order_relaxed);
+    slot.cpuPercent.store(cpuPercent, std::memory_order_relaxed);
+    slot.minorFaults.store(minorFaults, std::memory_order_relaxed);
+    slot.deviceUsedBytes.store(deviceUsed, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    written.store(index + 1, std::memory_order_release);
+
+    double cost = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    totalSampleCost.store(totalSampleCost.load(std::memory_order_relaxed) + cost, std::memory_order_relaxed);
+}
+
+std::vector<ResourceSample> ResourceSampler::snapshot() const {
+    std::vector<ResourceSample> samples;
+    uint64_t end = written.load(std::memory_order_acquire);
+    uint64_t begin = end > RESOURCE_SAMPLE_RING_SIZE ? end - RESOURCE_SAMPLE_RING_SIZE : 0;
+    samples.reserve(end - begin);
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots[index & (RESOURCE_SAMPLE_RING_SIZE - 1)];
+        ResourceSample sample;
+        uint64_t before, after, stored;
+        do {
+            before = slot.sequence.load(std::memory_order_acquire);
+            stored = slot.index.load(std::memory_order_relaxed);
+            sample.time = std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(slot.time.load(std::memory_order_relaxed)));
+            sample.rssBytes = slot.rssBytes.load(std::memory_order_relaxed);
+            sample.cpuPercent = slot.cpuPercent.load(std::memory_order_relaxed);
+            sample.minorFaults = slot.minorFaults.load(std::memory_order_relaxed);
+            sample.deviceUsedBytes = slot.deviceUsedBytes.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        // Overwritten by a newer sample while we were reading older ones
+        if (stored != index) {
+            continue;
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+ResourceSummary ResourceSampler::summarize(const std::vector<InferenceWindow>& windows) const {
+    ResourceSummary summary;
+    std::vector<ResourceSample> samples = snapshot();
+    if (samples.size() < 2 || windows.empty()) {
+        return summary;
+    }
+
+    size_t lowestDevice = samples[0].deviceUsedBytes;
+    size_t peakDevice = 0;
+    double totalCpu = 0.0, totalRss = 0.0;
+    size_t w = 0;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        const ResourceSample& previous = samples[i - 1];
+        const ResourceSample& sample = samples[i];
+        lowestDevice = std::min(lowestDevice, sample.deviceUsedBytes);
+
+        // Windows are ordered by start, skip the ones that ended before this interval
+        while (w < windows.size() && windows[w].second <= previous.time) {
+            ++w;
+        }
+        if (w == windows.size() || windows[w].first >= sample.time) {
+            continue;
+        }
+        summary.samples++;
+        totalCpu += sample.cpuPercent;
+        totalRss += sample.rssBytes;
+        summary.peakRssBytes = std::max(summary.peakRssBytes, sample.rssBytes);
+        summary.pageFaults += sample.minorFaults - previous.minorFaults;
+        peakDevice = std::max(peakDevice, sample.deviceUsedBytes);
+    }
+    if (summary.samples > 0) {
+        summary.averageCpuPercent = totalCpu / summary.samples;
+        summary.averageRssBytes = totalRss / summary.samples;
+        summary.peakDeviceUsedBytes = peakDevice > lowestDevice ? peakDevice - lowestDevice : 0;
+    }
+    return summary;
+}
+
+double ResourceSampler::getAverageSampleCost() const {
+    uint64_t count = written.load(std::memory_order_acquire);
+    return count > 0 ? totalSampleCost.load(std::memory_order_relaxed) / count : 0.0;
+}
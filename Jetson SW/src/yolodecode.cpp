@@ -0,0 +1,63 @@
+#include "yolodecode.h"
+#include <algorithm>
+
+// Box of one output row in frame coordinates
+static cv::Rect toFrameRect(const float* row, const cv::Rect& area) {
+    int centerX = area.x + static_cast<int>(row[0] * area.width);
+    int centerY = area.y + static_cast<int>(row[1] * area.height);
+    int width = static_cast<int>(row[2] * area.width);
+    int height = static_cast<int>(row[3] * area.height);
+    return cv::Rect(centerX - width / 2, centerY - height / 2, width, height);
+}
+
+// Append the rows of 'out' whose objectness (column 4) is above 'threshold' to 'rows'
+static void filterObjectness(const cv::Mat& out, float threshold, std::vector<int>& rows) {
+    if (out.rows == 0 || out.cols < 5) {
+        return;
+    }
+    const float* objectness = out.ptr<float>(0) + 4;
+    const size_t stride = out.step1();
+    // One strided load per row, almost every row is background and is skipped before a box is built
+    for (int i = 0; i < out.rows; ++i) {
+        if (objectness[i * stride] > threshold) {
+            rows.push_back(i);
+        }
+    }
+}
+
+size_t decodeFaces(const std::vector<cv::Mat>& outs, const cv::Rect& area, float threshold,
+                   std::vector<FaceCandidate>& faces) {
+    // Per-thread scratch, reused across calls
+    static thread_local std::vector<int> rows;
+    static thread_local std::vector<cv::Rect> boxes;
+    static thread_local std::vector<float> scores;
+    static thread_local std::vector<int> kept;
+    boxes.clear();
+    scores.clear();
+    faces.clear();
+
+    for (const auto& out : outs) {
+        rows.clear();
+        filterObjectness(out, threshold, rows);
+        for (int row : rows) {
+            const float* detection = out.ptr<float>(row);
+            boxes.push_back(toFrameRect(detection, area));
+            scores.push_back(detection[4]);
+        }
+    }
+    if (boxes.empty()) {
+        return 0;
+    }
+
+    kept.clear();
+    cv::dnn::NMSBoxes(boxes, scores, threshold, YOLO_NMS_THRESHOLD, kept);
+    faces.reserve(kept.size());
+    for (int index : kept) {
+        faces.push_back(FaceCandidate{boxes[index], scores[index]});
+    }
+    // NMSBoxes keeps score order in current OpenCV, do not rely on it
+    std::sort(faces.begin(), faces.end(), [](const FaceCandidate& a, const FaceCandidate& b) {
+        return a.confidence > b.confidence;
+    });
+    return boxes.size();
+}
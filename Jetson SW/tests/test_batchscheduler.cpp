@@ -0,0 +1,119 @@
+#include "batchscheduler.h"
+#include "inferencebackend.h"
+#include "testcheck.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/* Small inputs keep the exact input mean representable, so outputs compare exactly */
+#define TEST_INPUT_SIZE         16
+#define TEST_OUTPUT_SIZE        9
+#define TEST_PRODUCERS          4
+#define TEST_REQUESTS           50
+
+// Input whose mean, the mock's output, tells the request apart from every other one
+static std::vector<float> distinctInput(int producer, int request) {
+    return std::vector<float>(TEST_INPUT_SIZE, static_cast<float>(producer * 1000 + request));
+}
+
+// Every caller gets the output of its own input, with several producers filling the batches
+static void testResultsScatteredToCallers() {
+    MockInferenceBackend backend(TEST_INPUT_SIZE, TEST_OUTPUT_SIZE, 200, 50);
+    BatchScheduler scheduler([&backend](const float* inputs, size_t count, std::vector<float>& outputs) {
+        return backend.inferBatch(inputs, count, TEST_INPUT_SIZE, outputs);
+    }, TEST_INPUT_SIZE, 4, std::chrono::microseconds(2000));
+
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < TEST_PRODUCERS; ++p) {
+        producers.emplace_back([&scheduler, &wrong, p] {
+            // A few requests in flight per producer, answered in submission order
+            std::vector<std::vector<float>> inputs;
+            std::vector<std::future<std::vector<float>>> results;
+            for (int r = 0; r < TEST_REQUESTS; ++r) {
+                inputs.push_back(distinctInput(p, r));
+            }
+            for (int r = 0; r < TEST_REQUESTS; ++r) {
+                results.push_back(scheduler.submit(inputs[r].data()));
+            }
+            for (int r = 0; r < TEST_REQUESTS; ++r) {
+                std::vector<float> output = results[r].get();
+                if (output != std::vector<float>(TEST_OUTPUT_SIZE, inputs[r][0])) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    CHECK(wrong == 0);
+    CHECK(scheduler.getAverageBatchSize() > 1.0);
+    CHECK(scheduler.getAverageBatchSize() <= 4.0);
+}
+
+// A failed batch answers every request in it with an empty output, and the next batch recovers
+static void testFailedRunner() {
+    std::atomic<bool> fail(true);
+    MockInferenceBackend backend(TEST_INPUT_SIZE, TEST_OUTPUT_SIZE, 0, 0);
+    BatchScheduler scheduler([&backend, &fail](const float* inputs, size_t count, std::vector<float>& outputs) {
+        if (fail) {
+            outputs.clear();
+            return false;
+        }
+        return backend.inferBatch(inputs, count, TEST_INPUT_SIZE, outputs);
+    }, TEST_INPUT_SIZE, 4, std::chrono::microseconds(500));
+
+    std::vector<float> first = distinctInput(0, 1), second = distinctInput(0, 2);
+    std::future<std::vector<float>> a = scheduler.submit(first.data());
+    std::future<std::vector<float>> b = scheduler.submit(second.data());
+    CHECK(a.get().empty());
+    CHECK(b.get().empty());
+
+    fail = false;
+    CHECK(scheduler.submit(first.data()).get() == std::vector<float>(TEST_OUTPUT_SIZE, first[0]));
+
+    // A runner that reports success with no outputs fails the batch as well
+    BatchScheduler empty([](const float*, size_t, std::vector<float>& outputs) {
+        outputs.clear();
+        return true;
+    }, TEST_INPUT_SIZE, 4, std::chrono::microseconds(500));
+    CHECK(empty.submit(first.data()).get().empty());
+}
+
+// Destroying the scheduler answers everything still queued instead of leaving a broken promise
+static void testDestructionWithPendingRequests() {
+    std::vector<std::vector<float>> inputs;
+    for (int r = 0; r < TEST_REQUESTS; ++r) {
+        inputs.push_back(distinctInput(1, r));
+    }
+    std::vector<std::future<std::vector<float>>> results;
+    {
+        MockInferenceBackend backend(TEST_INPUT_SIZE, TEST_OUTPUT_SIZE, 1000, 0);
+        BatchScheduler scheduler([&backend](const float* inputs, size_t count, std::vector<float>& outputs) {
+            return backend.inferBatch(inputs, count, TEST_INPUT_SIZE, outputs);
+        }, TEST_INPUT_SIZE, 4, std::chrono::microseconds(100000));
+        for (int r = 0; r < TEST_REQUESTS; ++r) {
+            results.push_back(scheduler.submit(inputs[r].data()));
+        }
+    }
+    int answered = 0;
+    for (int r = 0; r < TEST_REQUESTS; ++r) {
+        CHECK(results[r].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        try {
+            if (results[r].get() == std::vector<float>(TEST_OUTPUT_SIZE, inputs[r][0])) {
+                answered++;
+            }
+        } catch (const std::future_error&) {
+            // Broken promise, counted as unanswered
+        }
+    }
+    CHECK(answered == TEST_REQUESTS);
+}
+
+int main() {
+    testResultsScatteredToCallers();
+    testFailedRunner();
+    testDestructionWithPendingRequests();
+    return testResult();
+}
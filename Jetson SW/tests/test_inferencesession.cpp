@@ -0,0 +1,79 @@
+#include "inferencesession.h"
+#include "testcheck.h"
+#include <vector>
+
+static const size_t inputSize = 3 * 224 * 224;
+static const size_t outputSize = 9;
+
+// Buffers are allocated once with the session and reused by every run
+static void testBuffersAllocatedOnce() {
+    MockSessionBackend* mock = new MockSessionBackend(inputSize, outputSize);
+    InferenceSession session(std::unique_ptr<ISessionBackend>(mock), inputSize, outputSize);
+    CHECK(mock->getAllocationCount() == 2);
+
+    std::vector<float> input(inputSize, 0.5f), output(outputSize, 0.0f);
+    for (int i = 0; i < 100; ++i) {
+        CHECK(session.run(input.data(), output.data()));
+    }
+    CHECK(mock->getAllocationCount() == 2);
+    CHECK(mock->getExecuteCount() == 100);
+    CHECK(session.getRunCount() == 100);
+    // The mock writes the input mean to every output
+    CHECK(output[0] == 0.5f && output[outputSize - 1] == 0.5f);
+}
+
+// A failed upload or download fails the run without executing or counting it
+static void testCopyFailure() {
+    MockSessionBackend* mock = new MockSessionBackend(inputSize, outputSize);
+    InferenceSession session(std::unique_ptr<ISessionBackend>(mock), inputSize, outputSize);
+    std::vector<float> input(inputSize, 1.0f), output(outputSize, -1.0f);
+
+    mock->setFailCopy(true);
+    CHECK(!session.run(input.data(), output.data()));
+    CHECK(mock->getExecuteCount() == 0);
+    CHECK(session.getRunCount() == 0);
+    CHECK(output[0] == -1.0f);
+
+    // The session recovers once the backend does, on the same buffers
+    mock->setFailCopy(false);
+    CHECK(session.run(input.data(), output.data()));
+    CHECK(session.getRunCount() == 1);
+    CHECK(mock->getAllocationCount() == 2);
+}
+
+// A failed execution fails the run and leaves the caller's output untouched
+static void testExecuteFailure() {
+    MockSessionBackend* mock = new MockSessionBackend(inputSize, outputSize);
+    InferenceSession session(std::unique_ptr<ISessionBackend>(mock), inputSize, outputSize);
+    std::vector<float> input(inputSize, 1.0f), output(outputSize, -1.0f);
+
+    mock->setFailExecute(true);
+    CHECK(!session.run(input.data(), output.data()));
+    CHECK(session.getRunCount() == 0);
+    CHECK(output[0] == -1.0f);
+
+    mock->setFailExecute(false);
+    CHECK(session.run(input.data(), output.data()));
+    CHECK(output[0] == 1.0f);
+}
+
+// Without buffers every run fails instead of touching a null binding
+static void testAllocationFailure() {
+    MockSessionBackend* mock = new MockSessionBackend(inputSize, outputSize);
+    mock->setFailAllocation(true);
+    InferenceSession session(std::unique_ptr<ISessionBackend>(mock), inputSize, outputSize);
+    std::vector<float> input(inputSize, 1.0f), output(outputSize, -1.0f);
+
+    mock->setFailAllocation(false);
+    CHECK(!session.run(input.data(), output.data()));
+    CHECK(mock->getExecuteCount() == 0);
+    CHECK(mock->getAllocationCount() == 0);
+}
+
+int main() {
+    testBuffersAllocatedOnce();
+    testCopyFailure();
+    testExecuteFailure();
+    testAllocationFailure();
+    return testResult();
+}
@@ -0,0 +1,43 @@
+#include "mappedfile.h"
+#include "testcheck.h"
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+static fs::path writeBlob(const std::vector<char>& blob) {
+    fs::path path = fs::temp_directory_path() / fs::unique_path("dms-mapped-test-%%%%-%%%%.bin");
+    std::ofstream out(path.string(), std::ios::binary);
+    out.write(blob.data(), blob.size());
+    return path;
+}
+
+int main() {
+    // Not a multiple of the page size, so the last page is partly past the end of the file
+    std::vector<char> blob(3 * 1024 * 1024 + 123);
+    for (size_t i = 0; i < blob.size(); ++i) {
+        blob[i] = static_cast<char>((i * 2654435761u) >> 24);
+    }
+    fs::path path = writeBlob(blob);
+    {
+        MappedFile mapped(path.string());
+        CHECK(mapped.isOpen());
+        CHECK(mapped.getSize() == blob.size());
+        CHECK(mapped.isOpen() && std::memcmp(mapped.getData(), blob.data(), blob.size()) == 0);
+    }
+    fs::remove(path);
+
+    // Missing and empty files are reported as not open instead of mapping nothing
+    MappedFile missing(path.string());
+    CHECK(!missing.isOpen());
+    CHECK(missing.getSize() == 0);
+
+    fs::path empty = writeBlob(std::vector<char>());
+    MappedFile emptyFile(empty.string());
+    CHECK(!emptyFile.isOpen());
+    fs::remove(empty);
+
+    return testResult();
+}
@@ -0,0 +1,97 @@
+#include "infer.h"
+#include "testcheck.h"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/* How long one model switch may take before the test calls it hung */
+#define SWAP_TIMEOUT_MS         5000
+
+static const size_t modelInputSize = 3 * ENGINE_INPUT_WIDTH * ENGINE_INPUT_HEIGHT;
+static const size_t modelBytes = 100 * 1024 * 1024;
+
+static std::atomic<int> loads(0);
+
+// Mock model named after its path, with a resident size so the cache budget applies
+class NamedMockBackend : public MockInferenceBackend {
+public:
+    explicit NamedMockBackend(const std::string& path)
+        : MockInferenceBackend(modelInputSize, ENGINE_OUTPUT_SIZE, 200, 0), path(path) {}
+    std::string getName() const override { return path; }
+    size_t getResidentBytes() const override { return modelBytes; }
+
+private:
+    std::string path;
+};
+
+// Switch head pose to 'path' and wait until it serves. A switch that never completes, or blocks
+// the caller, ends the test as a failure instead of stalling make test
+static void switchHeadPose(TRTEngineSingleton* trt, const std::string& path) {
+    std::atomic<bool> returned(false);
+    std::thread caller([trt, path, &returned] {
+        trt->setEngine1(path);
+        returned = true;
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SWAP_TIMEOUT_MS);
+    while (!(returned && trt->getHeadPoseBackendName() == path)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cerr << "Switch to " << path << " did not complete in " << SWAP_TIMEOUT_MS << " ms" << std::endl;
+            std::_Exit(1);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    caller.join();
+}
+
+int main() {
+    TRTEngineSingleton* trt = TRTEngineSingleton::getInstance();
+    trt->setModelFactory([](const std::string& path, InferenceBackendType) {
+        loads++;
+        return std::unique_ptr<IInferenceBackend>(new NamedMockBackend(path));
+    });
+    switchHeadPose(trt, "A");
+
+    // Inference keeps running through every switch and never sees an empty slot
+    std::atomic<bool> running(true);
+    std::atomic<int> inferences(0), defaults(0);
+    std::thread inference([trt, &running, &inferences, &defaults] {
+        std::vector<float> input(modelInputSize, 0.5f);
+        while (running) {
+            std::vector<float> output = trt->inferHeadPose(input.data());
+            inferences++;
+            if (output.empty() || output[0] != 0.5f) {
+                defaults++;
+            }
+        }
+    });
+
+    // Back and forth between two models, the second round comes from the cache
+    switchHeadPose(trt, "B");
+    switchHeadPose(trt, "A");
+    switchHeadPose(trt, "B");
+    switchHeadPose(trt, "A");
+    CHECK(loads == 2);
+    CHECK(trt->getSwapCount() == 5);
+
+    // Room for one model: B, the least recently used, goes
+    trt->setModelCacheBudget(150);
+    switchHeadPose(trt, "B");
+    CHECK(loads == 3);
+
+    // Nothing cached: the serving model is evicted from the cache but keeps serving
+    trt->setModelCacheBudget(0);
+    int before = inferences;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(inferences > before);
+    CHECK(trt->getHeadPoseBackendName() == "B");
+    switchHeadPose(trt, "A");
+    CHECK(loads == 4);
+
+    running = false;
+    inference.join();
+    CHECK(inferences > 0);
+    CHECK(defaults == 0);
+
+    return testResult();
+}
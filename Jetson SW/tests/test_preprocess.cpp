@@ -0,0 +1,55 @@
+#include "preprocess.h"
+#include "testcheck.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// The fused kernel computes pixel * scale + offset where the reference computes
+// (pixel / 255 - mean) / std. Outputs stay within about +-2.7, so the two float orderings differ
+// by a few ulps (~1e-6); anything above this is a real bug (wrong channel, plane or row)
+/* Largest accepted difference between preprocessToCHW and preprocessToCHWReference */
+#define PREPROCESS_TOLERANCE    1e-4
+
+static double maxDifference(const cv::Mat& image, cv::Size size) {
+    std::vector<float> fused(3 * size.area()), reference(3 * size.area());
+    preprocessToCHW(image, size, fused.data());
+    preprocessToCHWReference(image, size, reference.data());
+    double maxError = 0;
+    for (size_t i = 0; i < fused.size(); ++i) {
+        maxError = std::max(maxError, static_cast<double>(std::fabs(fused[i] - reference[i])));
+    }
+    return maxError;
+}
+
+static cv::Mat randomImage(cv::Size size, int type) {
+    cv::Mat image(size, type);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+    return image;
+}
+
+int main() {
+    cv::theRNG().state = 12345;
+    const cv::Size engineInput(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+
+    // Camera frame and a face crop down to the engine input
+    CHECK(maxDifference(randomImage(cv::Size(640, 480), CV_8UC3), engineInput) <= PREPROCESS_TOLERANCE);
+    CHECK(maxDifference(randomImage(cv::Size(173, 211), CV_8UC3), engineInput) <= PREPROCESS_TOLERANCE);
+
+    // Widths that are not a multiple of the 16-pixel vector step exercise the scalar tail
+    CHECK(maxDifference(randomImage(cv::Size(300, 200), CV_8UC3), cv::Size(37, 23)) <= PREPROCESS_TOLERANCE);
+    CHECK(maxDifference(randomImage(cv::Size(50, 50), CV_8UC3), cv::Size(15, 9)) <= PREPROCESS_TOLERANCE);
+
+    // Gray and BGRA input are converted to BGR first
+    CHECK(maxDifference(randomImage(cv::Size(320, 240), CV_8UC1), engineInput) <= PREPROCESS_TOLERANCE);
+    CHECK(maxDifference(randomImage(cv::Size(320, 240), CV_8UC4), engineInput) <= PREPROCESS_TOLERANCE);
+
+    // Planes are R, G, B: a pure blue image is lowest in R and highest in B
+    cv::Mat blue(cv::Size(64, 64), CV_8UC3, cv::Scalar(255, 0, 0));
+    std::vector<float> planes(3 * 16 * 16);
+    preprocessToCHW(blue, cv::Size(16, 16), planes.data());
+    CHECK(std::fabs(planes[0] - (0.0f - 0.485f) / 0.229f) <= PREPROCESS_TOLERANCE);
+    CHECK(std::fabs(planes[256] - (0.0f - 0.456f) / 0.224f) <= PREPROCESS_TOLERANCE);
+    CHECK(std::fabs(planes[512] - (1.0f - 0.406f) / 0.225f) <= PREPROCESS_TOLERANCE);
+
+    return testResult();
+}
@@ -0,0 +1,102 @@
+#include "preprocesscache.h"
+#include "testcheck.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Largest difference allowed against the scalar float-domain reference */
+#define PREPROCESS_TOLERANCE    1e-4f
+/* Against preprocessToCHW, which resizes the 8-bit image: half a gray level after normalization */
+#define RESAMPLE_TOLERANCE      (0.5f / (255.0f * 0.224f) + PREPROCESS_TOLERANCE)
+
+static float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return a.size() == b.size() ? worst : INFINITY;
+}
+
+// Normalize 'image' pixel by pixel with the original formula, then resize the float image once
+// and lay it out as planes
+static std::vector<float> referenceInput(const cv::Mat& image, cv::Size size) {
+    const float meanRGB[3] = {0.485f, 0.456f, 0.406f};
+    const float stdRGB[3] = {0.229f, 0.224f, 0.225f};
+    cv::Mat normalized(image.size(), CV_32FC3);
+    for (int y = 0; y < image.rows; ++y) {
+        for (int x = 0; x < image.cols; ++x) {
+            const cv::Vec3b& pixel = image.at<cv::Vec3b>(y, x);
+            for (int c = 0; c < 3; ++c) {
+                normalized.at<cv::Vec3f>(y, x)[c] = (pixel[2 - c] / 255.0f - meanRGB[c]) / stdRGB[c];
+            }
+        }
+    }
+    cv::Mat resized;
+    cv::resize(normalized, resized, size);
+    std::vector<float> tensor(3 * size.area());
+    for (int y = 0; y < size.height; ++y) {
+        for (int x = 0; x < size.width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                tensor[c * size.area() + y * size.width + x] = resized.at<cv::Vec3f>(y, x)[c];
+            }
+        }
+    }
+    return tensor;
+}
+
+int main() {
+    cv::Mat frame(cv::Size(640, 480), CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    const cv::Rect roi(200, 100, 180, 220);
+    const cv::Mat crop = frame(roi);
+    const cv::Size size(ENGINE_INPUT_WIDTH, ENGINE_INPUT_HEIGHT);
+
+    PreprocessCache cache;
+    std::shared_ptr<const PreprocessedFace> first = cache.lookup(1, roi, crop);
+    CHECK(cache.getMisses() == 1);
+    CHECK(cache.getHits() == 0);
+
+    // Both inputs come from one normalized crop, each resized once: head pose from all of it, eye
+    // gaze from its upper rows
+    const int eyeGazeRows = static_cast<int>(crop.rows * EYE_GAZE_CROP_RATIO);
+    const cv::Mat eyeGazeCrop = crop(cv::Rect(0, 0, crop.cols, eyeGazeRows));
+    CHECK(maxDifference(first->headPose, referenceInput(crop, size)) <= PREPROCESS_TOLERANCE);
+    CHECK(maxDifference(first->eyeGaze, referenceInput(eyeGazeCrop, size)) <= PREPROCESS_TOLERANCE);
+
+    // Resizing after normalization only moves a value by the 8-bit rounding of the single-model path
+    std::vector<float> single(3 * size.area());
+    preprocessToCHW(crop, size, single.data());
+    CHECK(maxDifference(first->headPose, single) <= RESAMPLE_TOLERANCE);
+    preprocessToCHW(eyeGazeCrop, size, single.data());
+    CHECK(maxDifference(first->eyeGaze, single) <= RESAMPLE_TOLERANCE);
+
+    // Same frame and ROI from another stage is a hit on the same entry
+    CHECK(cache.lookup(1, roi, crop) == first);
+    CHECK(cache.getHits() == 1);
+
+    // A new frame or a moved face is a miss
+    const cv::Rect moved(204, 100, 180, 220);
+    cache.lookup(2, roi, crop);
+    cache.lookup(2, moved, frame(moved));
+    CHECK(cache.getMisses() == 3);
+
+    // A held entry is never overwritten when its slot comes round again
+    std::vector<float> held = first->headPose;
+    for (uint64_t frameId = 3; frameId < 3 + 2 * PREPROCESS_CACHE_SIZE; ++frameId) {
+        cache.lookup(frameId, roi, crop);
+    }
+    CHECK(first->frameId == 1);
+    CHECK(first->headPose == held);
+
+    cache.resetMetrics();
+    CHECK(cache.getHits() == 0 && cache.getMisses() == 0);
+
+    // Crop widths that leave a scalar tail after the 16-pixel steps
+    for (int width : {1, 15, 17, 37}) {
+        const cv::Rect narrow(10, 10, width, 40);
+        std::shared_ptr<const PreprocessedFace> entry = cache.lookup(100 + width, narrow, frame(narrow));
+        CHECK(maxDifference(entry->headPose, referenceInput(frame(narrow), size)) <= PREPROCESS_TOLERANCE);
+    }
+
+    return testResult();
+}
@@ -0,0 +1,58 @@
+#include "threadsafequeue.h"
+#include "testcheck.h"
+
+// A mailbox cannot go lock-free, the ring has no way to overwrite from the producer side
+static void testMailboxStaysOnMutex() {
+    ThreadSafeQueue<int> queue;
+    CHECK(queue.makeMailbox());
+    CHECK(!queue.enableLockFree(8));
+    CHECK(!queue.isLockFree());
+    queue.push(1);
+    queue.push(2);
+    int item = 0;
+    CHECK(queue.tryPop(item) && item == 2);
+}
+
+// DropOldest is not silently turned into drop-newest on the ring
+static void testDropOldestStaysOnMutex() {
+    ThreadSafeQueue<int> queue;
+    CHECK(queue.setCapacity(2, OverflowPolicy::DropOldest));
+    CHECK(!queue.enableLockFree(2));
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    int item = 0;
+    CHECK(queue.tryPop(item) && item == 2);
+    CHECK(queue.getDroppedCount() == 1);
+}
+
+// Once lock-free, the ring keeps its capacity and only takes policies it can enforce
+static void testRingRejectsChanges() {
+    ThreadSafeQueue<int> queue;
+    CHECK(queue.setCapacity(4, OverflowPolicy::Block));
+    CHECK(queue.enableLockFree(4));
+    CHECK(queue.isLockFree());
+    CHECK(!queue.enableLockFree(8));
+    CHECK(!queue.makeMailbox());
+    CHECK(!queue.setCapacity(4, OverflowPolicy::DropOldest));
+    CHECK(!queue.setCapacity(16, OverflowPolicy::Block));
+    CHECK(queue.getPolicy() == OverflowPolicy::Block);
+    CHECK(queue.getCapacity() == 4);
+
+    // DropNewest on a full ring drops the pushed item and keeps the queued ones
+    CHECK(queue.setCapacity(4, OverflowPolicy::DropNewest));
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.push(i));
+    }
+    CHECK(!queue.push(4));
+    CHECK(queue.getDroppedCount() == 1);
+    int item = -1;
+    CHECK(queue.tryPop(item) && item == 0);
+}
+
+int main() {
+    testMailboxStaysOnMutex();
+    testDropOldestStaysOnMutex();
+    testRingRejectsChanges();
+    return testResult();
+}
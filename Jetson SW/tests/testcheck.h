@@ -0,0 +1,26 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal checks for the tests/ binaries: a failed CHECK is reported with its location and the
+// test keeps going, main returns testResult() so make test stops on the first failing binary
+
+static int testFailures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition     \
+                      << std::endl;                                                       \
+            ++testFailures;                                                               \
+        }                                                                                 \
+    } while (0)
+
+static int testResult() {
+    if (testFailures == 0) {
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+    std::cout << testFailures << " check(s) failed" << std::endl;
+    return 1;
+}